@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "acl_telemetry.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/time.h"
+
+void acl_telemetry_init(acl_telemetry_t * telemetry){
+    memset(telemetry, 0, sizeof(acl_telemetry_t));
+}
+
+void acl_telemetry_can_send_now_requested(acl_telemetry_t * telemetry, hci_con_handle_t con_handle){
+    telemetry->can_send_now_requests++;
+    if (hci_number_free_acl_slots_for_handle(con_handle) == 0){
+        telemetry->reports_delayed++;
+    }
+    if (telemetry->can_send_now_pending) return;
+    telemetry->can_send_now_pending = true;
+    telemetry->can_send_now_request_us = time_us_32();
+}
+
+void acl_telemetry_can_send_now(acl_telemetry_t * telemetry){
+    telemetry->can_send_now_events++;
+    if (telemetry->can_send_now_pending == false) return;
+    telemetry->can_send_now_pending = false;
+    uint32_t wait_us = time_us_32() - telemetry->can_send_now_request_us;
+    telemetry->can_send_now_waits++;
+    telemetry->can_send_now_wait_total_us += wait_us;
+    if (wait_us > telemetry->can_send_now_wait_max_us){
+        telemetry->can_send_now_wait_max_us = wait_us;
+    }
+}
+
+void acl_telemetry_report_coalesced(acl_telemetry_t * telemetry){
+    telemetry->reports_coalesced++;
+}
+
+void acl_telemetry_report_sent(acl_telemetry_t * telemetry, hci_con_handle_t con_handle){
+    telemetry->reports_sent++;
+    int free_slots = hci_number_free_acl_slots_for_handle(con_handle);
+    if (free_slots == 0){
+        telemetry->acl_buffers_exhausted++;
+    }
+    // the controller may offer more buffers than the stack uses, clamp to the stack's limit
+    if (free_slots > MAX_NR_CONTROLLER_ACL_BUFFERS){
+        free_slots = MAX_NR_CONTROLLER_ACL_BUFFERS;
+    }
+    telemetry->acl_outstanding = (uint8_t) (MAX_NR_CONTROLLER_ACL_BUFFERS - free_slots);
+    if (telemetry->acl_outstanding > telemetry->acl_outstanding_max){
+        telemetry->acl_outstanding_max = telemetry->acl_outstanding;
+    }
+}
+
+void acl_telemetry_report_received(acl_telemetry_t * telemetry){
+    telemetry->reports_received++;
+}
+
+void acl_telemetry_connection_closed(acl_telemetry_t * telemetry){
+    // CAN_SEND_NOW for a closed connection never arrives
+    telemetry->can_send_now_pending = false;
+    telemetry->acl_outstanding = 0;
+}
+
+void acl_telemetry_dump(const acl_telemetry_t * telemetry){
+    uint32_t wait_avg_us = 0;
+    if (telemetry->can_send_now_waits > 0){
+        wait_avg_us = (uint32_t) (telemetry->can_send_now_wait_total_us / telemetry->can_send_now_waits);
+    }
+    printf("ACL: outstanding %u, high-water %u of %u, buffers exhausted %" PRIu32 "x\n",
+           telemetry->acl_outstanding, telemetry->acl_outstanding_max, MAX_NR_CONTROLLER_ACL_BUFFERS,
+           telemetry->acl_buffers_exhausted);
+    printf("CAN_SEND_NOW: %" PRIu32 " requests, %" PRIu32 " events, wait avg %" PRIu32 " us, max %" PRIu32 " us\n",
+           telemetry->can_send_now_requests, telemetry->can_send_now_events, wait_avg_us,
+           telemetry->can_send_now_wait_max_us);
+    printf("Reports: %" PRIu32 " sent, %" PRIu32 " received, %" PRIu32 " coalesced, %" PRIu32 " delayed by backpressure\n",
+           telemetry->reports_sent, telemetry->reports_received, telemetry->reports_coalesced,
+           telemetry->reports_delayed);
+}
@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ACL_TELEMETRY_H
+#define ACL_TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "btstack.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Counters for reports stalled by ACL flow control. The stack only hands
+ * MAX_NR_CONTROLLER_ACL_BUFFERS packets to the controller at a time. After that,
+ * CAN_SEND_NOW is delayed until the controller reports completed packets.
+ */
+typedef struct {
+    // ACL packets handed to the controller and not completed yet, sampled after each send
+    uint8_t  acl_outstanding;
+    uint8_t  acl_outstanding_max;
+    uint32_t acl_buffers_exhausted;         // sends that took the last free controller buffer
+
+    // hid_device_request_can_send_now_event() -> HID_SUBEVENT_CAN_SEND_NOW
+    uint32_t can_send_now_requests;
+    uint32_t can_send_now_events;
+    uint32_t can_send_now_waits;            // events that answered a pending request, measured below
+    uint32_t can_send_now_wait_max_us;
+    uint64_t can_send_now_wait_total_us;
+    bool     can_send_now_pending;
+    uint32_t can_send_now_request_us;
+
+    // reports
+    uint32_t reports_sent;
+    uint32_t reports_received;
+    uint32_t reports_coalesced;             // changes merged into a report already waiting for CAN_SEND_NOW
+    uint32_t reports_delayed;               // requested while no controller buffer was free
+} acl_telemetry_t;
+
+/**
+ * @brief Reset all counters
+ * @param telemetry
+ */
+void acl_telemetry_init(acl_telemetry_t * telemetry);
+
+/**
+ * @brief Call right after hid_device_request_can_send_now_event()
+ * @param telemetry
+ * @param con_handle of the HID connection
+ */
+void acl_telemetry_can_send_now_requested(acl_telemetry_t * telemetry, hci_con_handle_t con_handle);
+
+/**
+ * @brief Call on HID_SUBEVENT_CAN_SEND_NOW
+ * @param telemetry
+ */
+void acl_telemetry_can_send_now(acl_telemetry_t * telemetry);
+
+/**
+ * @brief Call when a change is merged into a report that was already requested
+ * @param telemetry
+ */
+void acl_telemetry_report_coalesced(acl_telemetry_t * telemetry);
+
+/**
+ * @brief Call right after a report was handed to the stack
+ * @param telemetry
+ * @param con_handle of the HID connection
+ */
+void acl_telemetry_report_sent(acl_telemetry_t * telemetry, hci_con_handle_t con_handle);
+
+/**
+ * @brief Call for each received report
+ * @param telemetry
+ */
+void acl_telemetry_report_received(acl_telemetry_t * telemetry);
+
+/**
+ * @brief Call when the HID connection closed, counters are kept
+ * @param telemetry
+ */
+void acl_telemetry_connection_closed(acl_telemetry_t * telemetry);
+
+/**
+ * @brief Print all counters
+ * @param telemetry
+ */
+void acl_telemetry_dump(const acl_telemetry_t * telemetry);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // ACL_TELEMETRY_H
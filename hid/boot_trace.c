@@ -0,0 +1,82 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "boot_trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/time.h"
+
+#if LIB_PICO_STDIO_USB
+#include "pico/stdio.h"
+#include "pico/stdio/driver.h"
+#include "pico/stdio_usb.h"
+
+static char         boot_trace_output[BOOT_TRACE_OUTPUT_SIZE];
+static unsigned int boot_trace_output_len;
+static unsigned int boot_trace_output_dropped;
+static bool         boot_trace_output_replayed;
+
+// called by stdio for all output. It is registered before the USB driver, so the buffered
+// output goes out before the USB driver prints the text that triggered the replay
+static void boot_trace_out_chars(const char * buf, int len){
+    if (boot_trace_output_replayed) return;
+    if (stdio_usb_connected() == false){
+        unsigned int space = sizeof(boot_trace_output) - boot_trace_output_len;
+        unsigned int bytes_to_copy = ((unsigned int) len < space) ? (unsigned int) len : space;
+        memcpy(&boot_trace_output[boot_trace_output_len], buf, bytes_to_copy);
+        boot_trace_output_len += bytes_to_copy;
+        boot_trace_output_dropped += (unsigned int) len - bytes_to_copy;
+        return;
+    }
+    boot_trace_output_replayed = true;
+    stdio_usb.out_chars(boot_trace_output, (int) boot_trace_output_len);
+    if (boot_trace_output_dropped){
+        char note[48];
+        int note_len = snprintf(note, sizeof(note), "[%u bytes of boot output dropped]\n", boot_trace_output_dropped);
+        stdio_usb.out_chars(note, note_len);
+    }
+}
+
+static stdio_driver_t boot_trace_stdio_driver = {
+    .out_chars = boot_trace_out_chars,
+#if PICO_STDIO_ENABLE_CRLF_SUPPORT
+    // buffered text is passed to the USB driver as is, translate it like the USB driver would
+    .crlf_enabled = PICO_STDIO_DEFAULT_CRLF,
+#endif
+};
+#endif
+
+static struct {
+    const char * phase;
+    uint32_t     time_us;
+} boot_trace_phases[BOOT_TRACE_MAX_PHASES];
+
+static unsigned int boot_trace_num_phases;
+
+void boot_trace_mark(const char * phase){
+    if (boot_trace_num_phases >= BOOT_TRACE_MAX_PHASES) return;
+    boot_trace_phases[boot_trace_num_phases].phase   = phase;
+    boot_trace_phases[boot_trace_num_phases].time_us = time_us_32();
+    boot_trace_num_phases++;
+}
+
+void boot_trace_defer_output(void){
+#if LIB_PICO_STDIO_USB
+    stdio_set_driver_enabled(&boot_trace_stdio_driver, true);
+#endif
+}
+
+void boot_trace_print(void){
+    printf("Boot trace (ms since power-on, +ms since previous phase):\n");
+    uint32_t previous_us = 0;
+    unsigned int i;
+    for (i = 0; i < boot_trace_num_phases; i++){
+        uint32_t time_us = boot_trace_phases[i].time_us;
+        printf("%6u.%03u  +%6u.%03u  %s\n", time_us / 1000, time_us % 1000,
+               (time_us - previous_us) / 1000, (time_us - previous_us) % 1000, boot_trace_phases[i].phase);
+        previous_us = time_us;
+    }
+}
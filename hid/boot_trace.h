@@ -0,0 +1,42 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#define BOOT_TRACE_MAX_PHASES 8
+
+// stdout buffered until the USB CDC port is opened, output beyond this is dropped
+#define BOOT_TRACE_OUTPUT_SIZE 2048
+
+/**
+ * @brief Hold back stdout until the host opened the USB CDC port, then replay it before newer output.
+ * Output printed while USB enumerates is otherwise lost. UART output is not affected.
+ * Call before stdio_init_all(). Without stdio over USB this does nothing.
+ */
+void boot_trace_defer_output(void);
+
+/**
+ * @brief Record the time since power-on at which a boot phase was reached.
+ * Cheap enough to call before stdio is usable, the trace is printed later.
+ * @param phase name, must stay valid (string literal)
+ */
+void boot_trace_mark(const char * phase);
+
+/**
+ * @brief Print all recorded phases with time since power-on and since the previous phase
+ */
+void boot_trace_print(void);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BOOT_TRACE_H
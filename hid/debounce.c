@@ -0,0 +1,56 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "debounce.h"
+
+#include <string.h>
+
+void debounce_init(debounce_t * debounce, uint32_t mask, uint8_t threshold){
+    memset(debounce, 0, sizeof(debounce_t));
+    debounce->mask = mask;
+    debounce->threshold = threshold ? threshold : 1;
+}
+
+uint32_t debounce_update(debounce_t * debounce, uint32_t active){
+    active &= debounce->mask;
+
+    // only inputs that differ from their debounced state or are still settling need work
+    uint32_t pending = (active ^ debounce->state) | debounce->unsettled;
+    uint32_t changed = 0;
+
+    while (pending){
+        int i = __builtin_ctz(pending);
+        uint32_t bit = 1u << i;
+        pending &= pending - 1;
+
+        uint8_t counter = debounce->counter[i];
+        if (active & bit){
+            if (counter < debounce->threshold) counter++;
+        } else {
+            if (counter > 0) counter--;
+        }
+        debounce->counter[i] = counter;
+
+        if (counter == debounce->threshold){
+            debounce->unsettled &= ~bit;
+            if ((debounce->state & bit) == 0){
+                debounce->state |= bit;
+                changed |= bit;
+            }
+        } else if (counter == 0){
+            debounce->unsettled &= ~bit;
+            if (debounce->state & bit){
+                debounce->state &= ~bit;
+                changed |= bit;
+            }
+        } else {
+            debounce->unsettled |= bit;
+        }
+    }
+    return changed;
+}
+
+uint32_t debounce_get_state(const debounce_t * debounce){
+    return debounce->state;
+}
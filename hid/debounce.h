@@ -0,0 +1,60 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Integrating debouncer for up to 32 inputs that are sampled together as one bit mask,
+ * e.g. the result of gpio_get_all(). It does not depend on the Pico SDK, so it builds on
+ * any host.
+ *
+ * Each input has a counter that moves one step towards the sampled level per sample.
+ * The debounced state only changes once the counter reaches 0 or threshold, so an edge
+ * is reported threshold samples after the input became stable, and bounces shorter
+ * than that are filtered out.
+ */
+typedef struct {
+    uint32_t mask;          // inputs handled
+    uint32_t state;         // debounced state, 1 = active
+    uint32_t unsettled;     // inputs with a counter between 0 and threshold
+    uint8_t  threshold;
+    uint8_t  counter[32];
+} debounce_t;
+
+/**
+ * @brief Init debouncer, all inputs start inactive
+ * @param debounce
+ * @param mask of inputs to debounce
+ * @param threshold number of samples for an edge to be accepted, 1..255
+ */
+void debounce_init(debounce_t * debounce, uint32_t mask, uint8_t threshold);
+
+/**
+ * @brief Process one sample
+ * @param debounce
+ * @param active inputs, 1 = active
+ * @return inputs whose debounced state changed with this sample
+ */
+uint32_t debounce_update(debounce_t * debounce, uint32_t active);
+
+/**
+ * @brief Get debounced state
+ * @param debounce
+ * @return active inputs
+ */
+uint32_t debounce_get_state(const debounce_t * debounce);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // DEBOUNCE_H
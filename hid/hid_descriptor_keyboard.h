@@ -0,0 +1,167 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HID_DESCRIPTOR_KEYBOARD_H
+#define HID_DESCRIPTOR_KEYBOARD_H
+
+#include <stdint.h>
+
+// Keyboard report descriptor, shared by the Classic and the HID-over-GATT keyboard.
+// Include after ENABLE_NKRO_REPORT and ENABLE_COMPOSITE are defined or not.
+
+#define REPORT_ID 0x01
+
+// number of keycodes in the 6KRO input report
+#define NUM_KEYS 6
+
+#ifdef ENABLE_NKRO_REPORT
+#define REPORT_ID_NKRO 0x02
+
+// NKRO bitmap covers Usage 0x00 (no event) up to 0x67 (Keypad =)
+#define NKRO_NUM_KEYCODES  0x68
+#define NKRO_BITMAP_SIZE   (NKRO_NUM_KEYCODES / 8)
+#endif
+
+#ifdef ENABLE_COMPOSITE
+// mouse and consumer control in the same descriptor, all reports share the interrupt channel
+#define REPORT_ID_MOUSE    0x03
+#define REPORT_ID_CONSUMER 0x04
+#endif
+
+// close to USB HID Specification 1.1, Appendix B.1
+static const uint8_t hid_descriptor_keyboard[] = {
+
+    0x05, 0x01,                    // Usage Page (Generic Desktop)
+    0x09, 0x06,                    // Usage (Keyboard)
+    0xa1, 0x01,                    // Collection (Application)
+
+    // Report ID
+
+    0x85, REPORT_ID,               // Report ID
+
+    // Modifier byte (input)
+
+    0x75, 0x01,                    //   Report Size (1)
+    0x95, 0x08,                    //   Report Count (8)
+    0x05, 0x07,                    //   Usage Page (Key codes)
+    0x19, 0xe0,                    //   Usage Minimum (Keyboard LeftControl)
+    0x29, 0xe7,                    //   Usage Maximum (Keyboard Right GUI)
+    0x15, 0x00,                    //   Logical Minimum (0)
+    0x25, 0x01,                    //   Logical Maximum (1)
+    0x81, 0x02,                    //   Input (Data, Variable, Absolute)
+
+    // Reserved byte (input)
+
+    0x75, 0x01,                    //   Report Size (1)
+    0x95, 0x08,                    //   Report Count (8)
+    0x81, 0x03,                    //   Input (Constant, Variable, Absolute)
+
+    // LED report + padding (output)
+
+    0x95, 0x05,                    //   Report Count (5)
+    0x75, 0x01,                    //   Report Size (1)
+    0x05, 0x08,                    //   Usage Page (LEDs)
+    0x19, 0x01,                    //   Usage Minimum (Num Lock)
+    0x29, 0x05,                    //   Usage Maximum (Kana)
+    0x91, 0x02,                    //   Output (Data, Variable, Absolute)
+
+    0x95, 0x01,                    //   Report Count (1)
+    0x75, 0x03,                    //   Report Size (3)
+    0x91, 0x03,                    //   Output (Constant, Variable, Absolute)
+
+    // Keycodes (input)
+
+    0x95, 0x06,                    //   Report Count (6)
+    0x75, 0x08,                    //   Report Size (8)
+    0x15, 0x00,                    //   Logical Minimum (0)
+    0x25, 0xff,                    //   Logical Maximum (1)
+    0x05, 0x07,                    //   Usage Page (Key codes)
+    0x19, 0x00,                    //   Usage Minimum (Reserved (no event indicated))
+    0x29, 0xff,                    //   Usage Maximum (Reserved)
+    0x81, 0x00,                    //   Input (Data, Array)
+
+#ifdef ENABLE_NKRO_REPORT
+
+    // Report ID
+
+    0x85, REPORT_ID_NKRO,          //   Report ID
+
+    // Modifier byte (input)
+
+    0x75, 0x01,                    //   Report Size (1)
+    0x95, 0x08,                    //   Report Count (8)
+    0x05, 0x07,                    //   Usage Page (Key codes)
+    0x19, 0xe0,                    //   Usage Minimum (Keyboard LeftControl)
+    0x29, 0xe7,                    //   Usage Maximum (Keyboard Right GUI)
+    0x15, 0x00,                    //   Logical Minimum (0)
+    0x25, 0x01,                    //   Logical Maximum (1)
+    0x81, 0x02,                    //   Input (Data, Variable, Absolute)
+
+    // Keycode bitmap (input)
+
+    0x75, 0x01,                    //   Report Size (1)
+    0x95, NKRO_NUM_KEYCODES,       //   Report Count (104)
+    0x05, 0x07,                    //   Usage Page (Key codes)
+    0x19, 0x00,                    //   Usage Minimum (Reserved (no event indicated))
+    0x29, NKRO_NUM_KEYCODES - 1,   //   Usage Maximum (Keypad =)
+    0x81, 0x02,                    //   Input (Data, Variable, Absolute)
+
+#endif
+
+    0xc0,                          // End collection
+
+#ifdef ENABLE_COMPOSITE
+
+    // Mouse: buttons, X, Y, same layout as the boot mouse report
+
+    0x05, 0x01,                    // Usage Page (Generic Desktop)
+    0x09, 0x02,                    // Usage (Mouse)
+    0xa1, 0x01,                    // Collection (Application)
+    0x85, REPORT_ID_MOUSE,         //   Report ID
+    0x09, 0x01,                    //   Usage (Pointer)
+    0xa1, 0x00,                    //   Collection (Physical)
+
+    0x05, 0x09,                    //     Usage Page (Button)
+    0x19, 0x01,                    //     Usage Minimum (Button 1)
+    0x29, 0x03,                    //     Usage Maximum (Button 3)
+    0x15, 0x00,                    //     Logical Minimum (0)
+    0x25, 0x01,                    //     Logical Maximum (1)
+    0x95, 0x03,                    //     Report Count (3)
+    0x75, 0x01,                    //     Report Size (1)
+    0x81, 0x02,                    //     Input (Data, Variable, Absolute)
+    0x95, 0x01,                    //     Report Count (1)
+    0x75, 0x05,                    //     Report Size (5)
+    0x81, 0x03,                    //     Input (Constant, Variable, Absolute)
+
+    0x05, 0x01,                    //     Usage Page (Generic Desktop)
+    0x09, 0x30,                    //     Usage (X)
+    0x09, 0x31,                    //     Usage (Y)
+    0x15, 0x81,                    //     Logical Minimum (-127)
+    0x25, 0x7f,                    //     Logical Maximum (127)
+    0x75, 0x08,                    //     Report Size (8)
+    0x95, 0x02,                    //     Report Count (2)
+    0x81, 0x06,                    //     Input (Data, Variable, Relative)
+
+    0xc0,                          //   End Collection
+    0xc0,                          // End Collection
+
+    // Consumer control: one 16-bit usage, 0 = none
+
+    0x05, 0x0c,                    // Usage Page (Consumer)
+    0x09, 0x01,                    // Usage (Consumer Control)
+    0xa1, 0x01,                    // Collection (Application)
+    0x85, REPORT_ID_CONSUMER,      //   Report ID
+    0x15, 0x00,                    //   Logical Minimum (0)
+    0x26, 0xff, 0x03,              //   Logical Maximum (0x3ff)
+    0x19, 0x00,                    //   Usage Minimum (0)
+    0x2a, 0xff, 0x03,              //   Usage Maximum (0x3ff)
+    0x75, 0x10,                    //   Report Size (16)
+    0x95, 0x01,                    //   Report Count (1)
+    0x81, 0x00,                    //   Input (Data, Array)
+    0xc0,                          // End Collection
+
+#endif
+};
+
+#endif // HID_DESCRIPTOR_KEYBOARD_H
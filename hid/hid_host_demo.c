@@ -49,12 +49,30 @@
  */
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdio.h>
 
 #include "btstack_config.h"
 #include "btstack.h"
+#include "btstack_tlv.h"
 
-#define MAX_ATTRIBUTE_VALUE_SIZE 300
+#include "acl_telemetry.h"
+#include "hid_report_plan.h"
+
+// Count received reports and ACL buffer usage of output reports, printed on disconnect ('t' on stdin)
+// #define ENABLE_ACL_TELEMETRY
+
+// Connect in boot protocol mode. Boot keyboard and mouse reports are decoded at fixed offsets, without the HID descriptor
+// #define ENABLE_FORCE_BOOT_MODE
+
+// Keep HID descriptors in TLV next to the link keys. Reports from known devices are decoded right after reconnect,
+// the descriptor from the SDP query only validates the cached one
+// #define ENABLE_DESCRIPTOR_CACHE
+#define DESCRIPTOR_CACHE_ENTRIES 4
+#define DESCRIPTOR_CACHE_MAX_LEN 300
+
+// HID descriptors of all connections share one arena in BTstack's HID Host, each packed at its actual length
+#define HID_DESCRIPTOR_ARENA_SIZE 1024
 
 static const char * remote_addr_string = "00:1A:7D:DA:71:01";
 
@@ -112,22 +130,96 @@ static const uint8_t keytable_us_shift[] = {
 }; 
 
 // SDP
-static uint8_t hid_descriptor_storage[MAX_ATTRIBUTE_VALUE_SIZE];
+static uint8_t hid_descriptor_storage[HID_DESCRIPTOR_ARENA_SIZE];
 
 // App
-static enum {
-    APP_IDLE,
-    APP_CONNECTED
-} app_state = APP_IDLE;
-
-static uint16_t hid_host_cid = 0;
-static bool     hid_host_descriptor_available = false;
+#ifdef ENABLE_FORCE_BOOT_MODE
+static hid_protocol_mode_t hid_host_report_mode = HID_PROTOCOL_MODE_BOOT;
+#else
 static hid_protocol_mode_t hid_host_report_mode = HID_PROTOCOL_MODE_REPORT_WITH_FALLBACK_TO_BOOT;
+#endif
+
+#ifdef ENABLE_ACL_TELEMETRY
+static acl_telemetry_t acl_telemetry;
+#endif
+
+// one bit per keyboard usage 0x00..0xff
+#define KEY_BITMAP_WORDS 8
+
+// Connected HID Device, slot is free if cid is 0
+typedef struct {
+    uint16_t            cid;
+    hci_con_handle_t    con_handle;
+    bd_addr_t           addr;
+    bool                descriptor_available;
+#ifdef ENABLE_DESCRIPTOR_CACHE
+    // cache entry found, its hash is compared with the descriptor from SDP
+    bool                descriptor_cache_hit;
+    uint32_t            descriptor_hash;
+    // report plan and LED report compiled from cached descriptor
+    bool                descriptor_cached;
+#endif
+    // time to first decoded report
+    uint32_t            opened_ms;
+    bool                first_report_decoded;
+    // protocol mode of the connection, reports are decoded accordingly
+    hid_protocol_mode_t protocol_mode;
+    // input report layout, compiled once the HID descriptor is available
+    hid_report_plan_t   report_plan;
+    bool                report_plan_valid;
+    // keys held in the last report
+    uint32_t            keys_pressed[KEY_BITMAP_WORDS];
+    bool                caps_lock;
+    uint16_t            led_report_id;
+    uint8_t             led_report_len;
+    uint8_t             led_caps_lock_bit;
+} hid_host_device_t;
+
+static hid_host_device_t hid_host_devices[MAX_NR_HID_HOST_CONNECTIONS];
+
+static hid_host_device_t * hid_host_device_for_cid(uint16_t cid){
+    int i;
+    for (i = 0; i < MAX_NR_HID_HOST_CONNECTIONS; i++){
+        if (hid_host_devices[i].cid == cid) return &hid_host_devices[i];
+    }
+    return NULL;
+}
+
+// take free slot for new connection, NULL if all slots are in use
+static hid_host_device_t * hid_host_device_alloc(uint16_t cid){
+    hid_host_device_t * device = hid_host_device_for_cid(0);
+    if (device == NULL) return NULL;
+    memset(device, 0, sizeof(hid_host_device_t));
+    device->cid = cid;
+    device->con_handle = HCI_CON_HANDLE_INVALID;
+    // HID_SUBEVENT_SET_PROTOCOL_RESPONSE may arrive before HID_SUBEVENT_CONNECTION_OPENED
+    device->protocol_mode = HID_PROTOCOL_MODE_REPORT;
+    return device;
+}
+
+static void hid_host_device_free(hid_host_device_t * device){
+    device->cid = 0;
+    device->con_handle = HCI_CON_HANDLE_INVALID;
+}
+
+// fixed slot plus the connection's share of the descriptor arena
+static void hid_host_print_memory(void){
+    uint16_t arena_used = 0;
+    int i;
+    for (i = 0; i < MAX_NR_HID_HOST_CONNECTIONS; i++){
+        const hid_host_device_t * device = &hid_host_devices[i];
+        if (device->cid == 0) continue;
+        uint16_t descriptor_len = hid_descriptor_storage_get_descriptor_len(device->cid);
+        arena_used += descriptor_len;
+        printf("Device 0x%04x: %u bytes state, %u bytes HID descriptor\n", device->cid, (unsigned int) sizeof(hid_host_device_t), descriptor_len);
+    }
+    printf("HID descriptor arena: %u of %u bytes used\n", arena_used, HID_DESCRIPTOR_ARENA_SIZE);
+}
 
 /* @section Main application configuration
  *
  * @text In the application configuration, L2CAP and HID host are initialized, and the link policies 
- * are set to allow sniff mode and role change. 
+ * are set to allow sniff mode and role change. Up to MAX_NR_HID_HOST_CONNECTIONS devices can be connected. 
  */
 
 /* LISTING_START(PanuSetup): Panu setup */
@@ -168,124 +260,372 @@ static void hid_host_setup(void){
 /*
  * @section HID Report Handler
  * 
- * @text Use BTstack's compact HID Parser to process incoming HID Report in Report protocol mode. 
- * Iterate over all fields and process fields with usage page = 0x07 / Keyboard
- * Check if SHIFT is down and process first character (don't handle multiple key presses)
+ * @text Use the report plan compiled from the HID descriptor to process incoming HID Report in Report protocol mode,
+ * or BTstack's compact HID Parser if the descriptor exceeds the plan limits.
+ * Iterate over all fields and collect pressed keys with usage page = 0x07 / Keyboard in a bitmap.
+ * This works for 6KRO array reports as well as for NKRO reports with one bit per key.
+ * Key down and key up events are found by XOR with the bitmap of the previous report.
  * 
  */
 
+// Log key down and key up events instead of printing the typed characters
+// #define ENABLE_KEY_EVENT_LOG
+
 #define NUM_KEYS 6
-static uint8_t last_keys[NUM_KEYS];
-static bool hid_host_caps_lock;
 
-static uint16_t hid_host_led_report_id;
-static uint8_t  hid_host_led_report_len;
-static uint8_t  hid_host_led_caps_lock_bit;
+// Keyboard page usages
+#define KEY_USAGE_ERROR_ROLL_OVER   0x01
+#define KEY_USAGE_ERROR_UNDEFINED   0x03
+#define KEY_USAGE_LEFT_CONTROL      0xe0    // first modifier, the boot report modifier byte holds 0xe0..0xe7
 
-static void hid_host_set_leds(void){
-    if (hid_host_led_report_len == 0) return;
+static void hid_host_set_leds(hid_host_device_t * device){
+    if (device->led_report_len == 0) return;
 
     uint8_t output_report[8];
 
-    uint8_t caps_lock_report_offset = hid_host_led_caps_lock_bit >> 3;
+    uint8_t caps_lock_report_offset = device->led_caps_lock_bit >> 3;
     if (caps_lock_report_offset >= sizeof(output_report)) return;
 
     memset(output_report, 0, sizeof(output_report));
-    if (hid_host_caps_lock){
-        output_report[caps_lock_report_offset] = 1 << (hid_host_led_caps_lock_bit & 0x07);
+    if (device->caps_lock){
+        output_report[caps_lock_report_offset] = 1 << (device->led_caps_lock_bit & 0x07);
     }
-    hid_host_send_set_report(hid_host_cid, HID_REPORT_TYPE_OUTPUT, hid_host_led_report_id, output_report, hid_host_led_report_len);
+    hid_host_send_set_report(device->cid, HID_REPORT_TYPE_OUTPUT, device->led_report_id, output_report, device->led_report_len);
+#ifdef ENABLE_ACL_TELEMETRY
+    acl_telemetry_report_sent(&acl_telemetry, device->con_handle);
+#endif
 }
 
-static void hid_host_demo_lookup_caps_lock_led(void){
+static void hid_host_demo_lookup_caps_lock_led(hid_host_device_t * device, const uint8_t * hid_descriptor, uint16_t hid_descriptor_len){
     btstack_hid_usage_iterator_t iterator;
-    const uint8_t *hid_descriptor = hid_descriptor_storage_get_descriptor_data(hid_host_cid);
-    const uint16_t hid_descriptor_len = hid_descriptor_storage_get_descriptor_len(hid_host_cid);
+    device->led_report_len = 0;
     btstack_hid_usage_iterator_init(&iterator, hid_descriptor, hid_descriptor_len, HID_REPORT_TYPE_OUTPUT);
     while (btstack_hid_usage_iterator_has_more(&iterator)){
         btstack_hid_usage_item_t item;
         btstack_hid_usage_iterator_get_item(&iterator, &item);
         if (item.usage_page == HID_USAGE_PAGE_LED && item.usage == HID_USAGE_LED_CAPS_LOCK){
-            hid_host_led_report_id     = item.report_id;
-            hid_host_led_report_len    = btstack_hid_get_report_size_for_id(hid_host_led_report_id, HID_REPORT_TYPE_OUTPUT, hid_descriptor, hid_descriptor_len);
-            hid_host_led_caps_lock_bit = (uint8_t) item.bit_pos;
-            printf("Found CAPS LOCK in Output Report with ID 0x%04x at bit %3u\n", hid_host_led_report_id, hid_host_led_caps_lock_bit);
+            device->led_report_id     = item.report_id;
+            device->led_report_len    = btstack_hid_get_report_size_for_id(device->led_report_id, HID_REPORT_TYPE_OUTPUT, hid_descriptor, hid_descriptor_len);
+            device->led_caps_lock_bit = (uint8_t) item.bit_pos;
+            printf("Found CAPS LOCK in Output Report with ID 0x%04x at bit %3u\n", device->led_report_id, device->led_caps_lock_bit);
+        }
+    }
+}
+
+// compile input report layout once per connection instead of parsing the descriptor for every report
+static void hid_host_demo_compile_report_plan(hid_host_device_t * device, const uint8_t * hid_descriptor, uint16_t hid_descriptor_len){
+    device->report_plan_valid = hid_report_plan_compile(&device->report_plan, hid_descriptor, hid_descriptor_len);
+    if (device->report_plan_valid){
+        printf("Report plan: %u fields in %u reports\n", device->report_plan.num_fields, device->report_plan.num_reports);
+    } else {
+        printf("Report plan: descriptor not supported, using HID parser\n");
+    }
+}
+
+#ifdef ENABLE_DESCRIPTOR_CACHE
+// TLV tags for cached HID descriptors, one per entry
+#define TLV_TAG_DESCRIPTOR_CACHE(entry) (((uint32_t) 'H' << 24) | ((uint32_t) 'D' << 16) | ((uint32_t) 'C' << 8) | ('0' + (entry)))
+
+typedef struct {
+    bd_addr_t addr;
+    uint16_t  descriptor_len;
+    uint32_t  hash;
+    uint32_t  sequence;         // entry with the lowest sequence is replaced first
+    uint8_t   descriptor[DESCRIPTOR_CACHE_MAX_LEN];
+} descriptor_cache_entry_t;
+
+// only header and descriptor_len bytes of the descriptor are stored
+#define DESCRIPTOR_CACHE_HEADER_LEN offsetof(descriptor_cache_entry_t, descriptor)
+
+static descriptor_cache_entry_t descriptor_cache_entry;
+
+// FNV-1a, detects a changed descriptor for the same address
+static uint32_t descriptor_hash(const uint8_t * descriptor, uint16_t descriptor_len){
+    uint32_t hash = 0x811c9dc5;
+    uint16_t i;
+    for (i = 0; i < descriptor_len; i++){
+        hash ^= descriptor[i];
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+// load entry into descriptor_cache_entry, returns false if the entry is empty or invalid
+static bool descriptor_cache_load(int entry){
+    const btstack_tlv_t * tlv_impl;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl == NULL) return false;
+    int len = tlv_impl->get_tag(tlv_context, TLV_TAG_DESCRIPTOR_CACHE(entry), (uint8_t *) &descriptor_cache_entry, sizeof(descriptor_cache_entry));
+    if (len < (int) DESCRIPTOR_CACHE_HEADER_LEN) return false;
+    if (descriptor_cache_entry.descriptor_len > DESCRIPTOR_CACHE_MAX_LEN) return false;
+    if (len != (int) (DESCRIPTOR_CACHE_HEADER_LEN + descriptor_cache_entry.descriptor_len)) return false;
+    return descriptor_hash(descriptor_cache_entry.descriptor, descriptor_cache_entry.descriptor_len) == descriptor_cache_entry.hash;
+}
+
+// store descriptor, replacing the entry of the same address, a free entry or the oldest one
+static void descriptor_cache_store(const bd_addr_t addr, const uint8_t * descriptor, uint16_t descriptor_len, uint32_t hash){
+    if (descriptor_len > DESCRIPTOR_CACHE_MAX_LEN) return;
+    const btstack_tlv_t * tlv_impl;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl == NULL) return;
+
+    int match = -1;
+    uint32_t match_hash = 0;
+    int free_entry = -1;
+    int oldest = 0;
+    uint32_t oldest_sequence = UINT32_MAX;
+    uint32_t next_sequence = 0;
+    int entry;
+    for (entry = 0; entry < DESCRIPTOR_CACHE_ENTRIES; entry++){
+        if (descriptor_cache_load(entry) == false){
+            if (free_entry < 0){
+                free_entry = entry;
+            }
+            continue;
+        }
+        if (bd_addr_cmp(descriptor_cache_entry.addr, addr) == 0){
+            match = entry;
+            match_hash = descriptor_cache_entry.hash;
+        }
+        if (descriptor_cache_entry.sequence < oldest_sequence){
+            oldest_sequence = descriptor_cache_entry.sequence;
+            oldest = entry;
+        }
+        if (descriptor_cache_entry.sequence >= next_sequence){
+            next_sequence = descriptor_cache_entry.sequence + 1;
+        }
+    }
+    // flash is only written if address or descriptor changed
+    if ((match >= 0) && (match_hash == hash)) return;
+    if (match >= 0){
+        entry = match;
+    } else if (free_entry >= 0){
+        entry = free_entry;
+    } else {
+        entry = oldest;
+    }
+
+    bd_addr_copy(descriptor_cache_entry.addr, addr);
+    descriptor_cache_entry.descriptor_len = descriptor_len;
+    descriptor_cache_entry.hash = hash;
+    descriptor_cache_entry.sequence = next_sequence;
+    memcpy(descriptor_cache_entry.descriptor, descriptor, descriptor_len);
+    tlv_impl->store_tag(tlv_context, TLV_TAG_DESCRIPTOR_CACHE(entry), (const uint8_t *) &descriptor_cache_entry, DESCRIPTOR_CACHE_HEADER_LEN + descriptor_len);
+    printf("Descriptor cache: stored %u bytes for %s in entry %u\n", descriptor_len, bd_addr_to_str(addr), entry);
+}
+
+// compile report plan from the cached descriptor, so reports can be decoded before the SDP query completes
+static void hid_host_descriptor_cache_lookup(hid_host_device_t * device){
+    int entry;
+    for (entry = 0; entry < DESCRIPTOR_CACHE_ENTRIES; entry++){
+        if (descriptor_cache_load(entry) == false) continue;
+        if (bd_addr_cmp(descriptor_cache_entry.addr, device->addr) == 0) break;
+    }
+    if (entry == DESCRIPTOR_CACHE_ENTRIES) return;
+    device->descriptor_cache_hit = true;
+    device->descriptor_hash = descriptor_cache_entry.hash;
+
+    // without a report plan, reports can only be decoded with the descriptor from the HID Host
+    hid_host_demo_compile_report_plan(device, descriptor_cache_entry.descriptor, descriptor_cache_entry.descriptor_len);
+    if (device->report_plan_valid == false) return;
+    hid_host_demo_lookup_caps_lock_led(device, descriptor_cache_entry.descriptor, descriptor_cache_entry.descriptor_len);
+    device->descriptor_cached = true;
+    printf("Descriptor cache: using %u bytes for %s\n", descriptor_cache_entry.descriptor_len, bd_addr_to_str(device->addr));
+}
+
+// check cached descriptor against the one from SDP and update the cache if needed. Returns true if it's still valid
+static bool hid_host_descriptor_cache_validate(hid_host_device_t * device, const uint8_t * descriptor, uint16_t descriptor_len){
+    uint32_t hash = descriptor_hash(descriptor, descriptor_len);
+    if (device->descriptor_cache_hit && (device->descriptor_hash == hash)){
+        // entry is up to date, even if no report plan could be compiled from it
+        if (device->descriptor_cached == false) return false;
+        printf("Descriptor cache: validated by SDP\n");
+        return true;
+    }
+    descriptor_cache_store(device->addr, descriptor, descriptor_len, hash);
+    return false;
+}
+#endif
+
+// time from connection opened to first decoded report, e.g. to compare reconnects with and without descriptor cache
+static void hid_host_first_report_decoded(hid_host_device_t * device){
+    if (device->first_report_decoded) return;
+    device->first_report_decoded = true;
+    printf("Device 0x%04x: first report decoded %u ms after connect\n", device->cid, btstack_run_loop_get_time_ms() - device->opened_ms);
+}
+
+// iterate over input report fields, using the report plan if available
+typedef struct {
+    bool                       use_plan;
+    hid_report_plan_iterator_t plan_iterator;
+    btstack_hid_parser_t       parser;
+} hid_host_report_iterator_t;
+
+static void hid_host_report_iterator_init(hid_host_report_iterator_t * iterator, const hid_host_device_t * device, const uint8_t * report, uint16_t report_len){
+    iterator->use_plan = device->report_plan_valid;
+    if (iterator->use_plan){
+        hid_report_plan_iterator_init(&iterator->plan_iterator, &device->report_plan, report, report_len);
+    } else {
+        btstack_hid_parser_init(&iterator->parser,
+            hid_descriptor_storage_get_descriptor_data(device->cid),
+            hid_descriptor_storage_get_descriptor_len(device->cid),
+            HID_REPORT_TYPE_INPUT, report, report_len);
+    }
+}
+
+static bool hid_host_report_iterator_get_field(hid_host_report_iterator_t * iterator, uint16_t * usage_page, uint16_t * usage, int32_t * value){
+    if (iterator->use_plan){
+        if (hid_report_plan_iterator_has_more(&iterator->plan_iterator) == false) return false;
+        hid_report_plan_iterator_get_field(&iterator->plan_iterator, usage_page, usage, value);
+    } else {
+        if (btstack_hid_parser_has_more(&iterator->parser) == false) return false;
+        btstack_hid_parser_get_field(&iterator->parser, usage_page, usage, value);
+    }
+    return true;
+}
+
+static void key_bitmap_set(uint32_t * bitmap, uint8_t usage){
+    bitmap[usage >> 5] |= 1u << (usage & 0x1f);
+}
+
+static bool key_bitmap_get(const uint32_t * bitmap, uint8_t usage){
+    return (bitmap[usage >> 5] & (1u << (usage & 0x1f))) != 0;
+}
+
+// ErrorRollOver, POSTFail, ErrorUndefined: keyboard state unknown, e.g. too many keys pressed for a 6KRO report
+static bool key_usage_is_error(uint16_t usage){
+    return (usage >= KEY_USAGE_ERROR_ROLL_OVER) && (usage <= KEY_USAGE_ERROR_UNDEFINED);
+}
+
+static void hid_host_handle_key_event(hid_host_device_t * device, uint8_t usage, bool pressed, bool shift){
+#ifdef ENABLE_KEY_EVENT_LOG
+    printf("Device 0x%04x: key 0x%02x %s\n", device->cid, usage, pressed ? "down" : "up");
+#endif
+    if (pressed == false) return;
+
+    if (usage == HID_USAGE_KEY_KEYBOARD_CAPS_LOCK){
+        // Toggle Caps Lock
+        device->caps_lock = !device->caps_lock;
+        // update LEDs
+        hid_host_set_leds(device);
+        return;
+    }
+
+#ifndef ENABLE_KEY_EVENT_LOG
+    if (usage >= sizeof(keytable_us_none)) return;
+    uint8_t key;
+    if (shift){
+        key = keytable_us_shift[usage];
+    } else {
+        key = keytable_us_none[usage];
+    }
+    if (key == CHAR_ILLEGAL) return;
+    if (key == CHAR_BACKSPACE){ 
+        printf("\b \b");    // go back one char, print space, go back one char again
+        return;
+    }
+    printf("%c", key);
+    fflush(stdout);
+#else
+    UNUSED(shift);
+#endif
+}
+
+// emit key down and key up events for all keys that changed since the last report
+static void hid_host_handle_keys(hid_host_device_t * device, const uint32_t * keys_pressed){
+    bool shift = key_bitmap_get(keys_pressed, HID_USAGE_KEY_KEYBOARD_LEFTSHIFT) ||
+                 key_bitmap_get(keys_pressed, HID_USAGE_KEY_KEYBOARD_RIGHTSHIFT) ||
+                 device->caps_lock;
+    int i;
+    for (i = 0; i < KEY_BITMAP_WORDS; i++){
+        uint32_t changed = keys_pressed[i] ^ device->keys_pressed[i];
+        while (changed){
+            uint8_t bit = (uint8_t) __builtin_ctz(changed);
+            changed &= changed - 1;
+            hid_host_handle_key_event(device, (uint8_t) ((i << 5) | bit), (keys_pressed[i] >> bit) & 1, shift);
+        }
+    }
+    memcpy(device->keys_pressed, keys_pressed, sizeof(device->keys_pressed));
+}
+
+// Boot protocol: fixed report layout, no HID descriptor needed
+
+#define BOOT_REPORT_ID_KEYBOARD 1
+#define BOOT_REPORT_ID_MOUSE    2
+
+
+// modifiers, reserved, 6 keycodes
+static void hid_host_handle_boot_keyboard_report(hid_host_device_t * device, const uint8_t * report, uint16_t report_len){
+    if (report_len < 2 + NUM_KEYS) return;
+    uint32_t keys_pressed[KEY_BITMAP_WORDS];
+    memset(keys_pressed, 0, sizeof(keys_pressed));
+    int i;
+    for (i = 0; i < 8; i++){
+        if (report[0] & (1 << i)){
+            key_bitmap_set(keys_pressed, KEY_USAGE_LEFT_CONTROL + i);
         }
     }
+    for (i = 0; i < NUM_KEYS; i++){
+        uint8_t usage = report[2 + i];
+        if (usage == HID_USAGE_KEY_RESERVED) continue;
+        if (key_usage_is_error(usage)) return;
+        key_bitmap_set(keys_pressed, usage);
+    }
+    hid_host_handle_keys(device, keys_pressed);
 }
 
-static void hid_host_handle_interrupt_report(const uint8_t * report, uint16_t report_len){
+// buttons, X, Y
+static void hid_host_handle_boot_mouse_report(const hid_host_device_t * device, const uint8_t * report, uint16_t report_len){
+    if (report_len < 3) return;
+    printf("Device 0x%04x: mouse %d/%d - buttons: %02x\n", device->cid, (int8_t) report[1], (int8_t) report[2], report[0]);
+}
+
+static void hid_host_handle_boot_report(hid_host_device_t * device, const uint8_t * report, uint16_t report_len){
+    // check if HID Input Report
+    if (report_len < 2) return;
+    if (report[0] != 0xa1) return;
+    switch (report[1]){
+        case BOOT_REPORT_ID_KEYBOARD:
+            hid_host_handle_boot_keyboard_report(device, &report[2], report_len - 2);
+            break;
+        case BOOT_REPORT_ID_MOUSE:
+            hid_host_handle_boot_mouse_report(device, &report[2], report_len - 2);
+            break;
+        default:
+            break;
+    }
+}
+
+static void hid_host_handle_interrupt_report(hid_host_device_t * device, const uint8_t * report, uint16_t report_len){
     // check if HID Input Report
     if (report_len < 1) return;
     if (*report != 0xa1) return; 
     
     report++;
     report_len--;
-    
-    btstack_hid_parser_t parser;
-    btstack_hid_parser_init(&parser, 
-        hid_descriptor_storage_get_descriptor_data(hid_host_cid), 
-        hid_descriptor_storage_get_descriptor_len(hid_host_cid), 
-        HID_REPORT_TYPE_INPUT, report, report_len);
-
-    bool shift = hid_host_caps_lock;
-    uint8_t new_keys[NUM_KEYS];
-    memset(new_keys, 0, sizeof(new_keys));
-    int     new_keys_count = 0;
-
-    while (btstack_hid_parser_has_more(&parser)){
-        uint16_t usage_page;
-        uint16_t usage;
-        int32_t  value;
-        btstack_hid_parser_get_field(&parser, &usage_page, &usage, &value);
-        if (usage_page != 0x07) continue;   
-        switch (usage){
-            case HID_USAGE_KEY_KEYBOARD_CAPS_LOCK:
-                // Toggle Caps Lock
-                hid_host_caps_lock = !hid_host_caps_lock;
-                // update LEDs
-                hid_host_set_leds();
-                break;
-            case HID_USAGE_KEY_KEYBOARD_LEFTSHIFT:
-            case HID_USAGE_KEY_KEYBOARD_RIGHTSHIFT:
-                if (value){
-                    shift = 1;
-                }
-                continue;
-            case HID_USAGE_KEY_RESERVED:
-                continue;
-            default:
-                break;
-        }
-        if (usage >= sizeof(keytable_us_none)) continue;
 
-        // store new keys
-        new_keys[new_keys_count++] = (uint8_t) usage;
+    hid_host_report_iterator_t iterator;
+    hid_host_report_iterator_init(&iterator, device, report, report_len);
 
-        // check if usage was used last time (and ignore in that case)
-        int i;
-        for (i=0;i<NUM_KEYS;i++){
-            if (usage == last_keys[i]){
-                usage = 0;
-            }
-        }
-        if (usage == 0) continue;
+    uint32_t keys_pressed[KEY_BITMAP_WORDS];
+    memset(keys_pressed, 0, sizeof(keys_pressed));
 
-        uint8_t key;
-        if (shift){
-            key = keytable_us_shift[usage];
-        } else {
-            key = keytable_us_none[usage];
-        }
-        if (key == CHAR_ILLEGAL) continue;
-        if (key == CHAR_BACKSPACE){ 
-            printf("\b \b");    // go back one char, print space, go back one char again
-            continue;
-        }
-        printf("%c", key);
-        fflush(stdout);
+    uint16_t usage_page;
+    uint16_t usage;
+    int32_t  value;
+    while (hid_host_report_iterator_get_field(&iterator, &usage_page, &usage, &value)){
+        if (usage_page != 0x07) continue;   
+        // array slots report their key with value 1, modifier and NKRO bits report 0 if not pressed
+        if (value == 0) continue;
+        if (usage == HID_USAGE_KEY_RESERVED) continue;
+        if (usage > 0xff) continue;
+        // keep previous state until the keyboard reports valid keys again
+        if (key_usage_is_error(usage)) return;
+        key_bitmap_set(keys_pressed, (uint8_t) usage);
     }
-    memcpy(last_keys, new_keys, NUM_KEYS);
+    hid_host_handle_keys(device, keys_pressed);
 }
 
 /*
@@ -294,6 +634,18 @@ static void hid_host_handle_interrupt_report(const uint8_t * report, uint16_t re
  * @text The packet handler responds to various HID events.
  */
 
+// outgoing connection, the device slot is taken once the HID Host accepted the request
+static uint8_t hid_host_demo_connect(void){
+    uint16_t hid_cid;
+    uint8_t status = hid_host_connect(remote_addr, hid_host_report_mode, &hid_cid);
+    if (status != ERROR_CODE_SUCCESS) return status;
+    if (hid_host_device_alloc(hid_cid) == NULL){
+        hid_host_disconnect(hid_cid);
+        return BTSTACK_MEMORY_ALLOC_FAILED;
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
 /* LISTING_START(packetHandler): Packet Handler */
 static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size)
 {
@@ -304,6 +656,10 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
     uint8_t   event;
     bd_addr_t event_addr;
     uint8_t   status;
+    uint16_t  hid_cid;
+    hid_host_device_t * device;
+    const uint8_t * descriptor;
+    uint16_t  descriptor_len;
 
     /* LISTING_RESUME */
     switch (packet_type) {
@@ -317,7 +673,7 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
                  */
                 case BTSTACK_EVENT_STATE:
                     if (btstack_event_state_get_state(packet) == HCI_STATE_WORKING){
-                        status = hid_host_connect(remote_addr, hid_host_report_mode, &hid_host_cid);
+                        status = hid_host_demo_connect();
                         if (status != ERROR_CODE_SUCCESS){
                             printf("HID host connect failed, status 0x%02x.\n", status);
                         }
@@ -347,25 +703,43 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
                             // The hid_host_report_mode in the hid_host_accept_connection function 
                             // allows the application to request a protocol mode. 
                             // For available protocol modes, see hid_protocol_mode_t in btstack_hid.h file. 
-                            hid_host_accept_connection(hid_subevent_incoming_connection_get_hid_cid(packet), hid_host_report_mode);
+                            hid_cid = hid_subevent_incoming_connection_get_hid_cid(packet);
+                            if (hid_host_device_alloc(hid_cid) == NULL){
+                                printf("All %u device slots in use, decline connection\n", MAX_NR_HID_HOST_CONNECTIONS);
+                                hid_host_decline_connection(hid_cid);
+                                break;
+                            }
+                            hid_host_accept_connection(hid_cid, hid_host_report_mode);
                             break;
                         
                         case HID_SUBEVENT_CONNECTION_OPENED:
                             // The status field of this event indicates if the control and interrupt
                             // connections were opened successfully.
                             status = hid_subevent_connection_opened_get_status(packet);
+                            hid_cid = hid_subevent_connection_opened_get_hid_cid(packet);
+                            device = hid_host_device_for_cid(hid_cid);
                             if (status != ERROR_CODE_SUCCESS) {
                                 printf("Connection failed, status 0x%02x\n", status);
-                                app_state = APP_IDLE;
-                                hid_host_cid = 0;
+                                if (device != NULL){
+                                    hid_host_device_free(device);
+                                }
                                 return;
                             }
-                            app_state = APP_CONNECTED;
-                            hid_host_descriptor_available = false;
-                            hid_host_cid = hid_subevent_connection_opened_get_hid_cid(packet);
-                            hid_host_caps_lock = false;
-                            hid_host_led_report_len = 0;
-                            printf("HID Host connected.\n");
+                            if (device == NULL){
+                                device = hid_host_device_alloc(hid_cid);
+                            }
+                            if (device == NULL){
+                                printf("All %u device slots in use, disconnect\n", MAX_NR_HID_HOST_CONNECTIONS);
+                                hid_host_disconnect(hid_cid);
+                                break;
+                            }
+                            device->con_handle = hid_subevent_connection_opened_get_con_handle(packet);
+                            hid_subevent_connection_opened_get_bd_addr(packet, device->addr);
+                            device->opened_ms = btstack_run_loop_get_time_ms();
+                            printf("HID Host connected device 0x%04x.\n", hid_cid);
+#ifdef ENABLE_DESCRIPTOR_CACHE
+                            hid_host_descriptor_cache_lookup(device);
+#endif
                             break;
 
                         case HID_SUBEVENT_DESCRIPTOR_AVAILABLE:
@@ -375,20 +749,39 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
                             // reports may be received via HID_SUBEVENT_REPORT event. It is up to 
                             // the application if these reports should be buffered or ignored until 
                             // the HID descriptor is available.
+                            device = hid_host_device_for_cid(hid_subevent_descriptor_available_get_hid_cid(packet));
+                            if (device == NULL) break;
                             status = hid_subevent_descriptor_available_get_status(packet);
                             if (status == ERROR_CODE_SUCCESS){
-                                hid_host_descriptor_available = true;
+                                device->descriptor_available = true;
+                                descriptor = hid_descriptor_storage_get_descriptor_data(device->cid);
+                                descriptor_len = hid_descriptor_storage_get_descriptor_len(device->cid);
+#ifdef ENABLE_DESCRIPTOR_CACHE
+                                if (hid_host_descriptor_cache_validate(device, descriptor, descriptor_len)) break;
+#endif
                                 printf("HID Descriptor available, please start typing.\n");
-                                hid_host_demo_lookup_caps_lock_led();
+                                hid_host_demo_lookup_caps_lock_led(device, descriptor, descriptor_len);
+                                hid_host_demo_compile_report_plan(device, descriptor, descriptor_len);
+                                hid_host_print_memory();
                             } else {
                                 printf("Cannot handle input report, HID Descriptor is not available, status 0x%02x\n", status);
                             }
                             break;
 
                         case HID_SUBEVENT_REPORT:
+#ifdef ENABLE_ACL_TELEMETRY
+                            acl_telemetry_report_received(&acl_telemetry);
+#endif
                             // Handle input report.
-                            if (hid_host_descriptor_available){
-                                hid_host_handle_interrupt_report(hid_subevent_report_get_report(packet), hid_subevent_report_get_report_len(packet));
+                            device = hid_host_device_for_cid(hid_subevent_report_get_hid_cid(packet));
+                            if (device == NULL) break;
+                            if (device->protocol_mode == HID_PROTOCOL_MODE_BOOT){
+                                hid_host_handle_boot_report(device, hid_subevent_report_get_report(packet), hid_subevent_report_get_report_len(packet));
+                                hid_host_first_report_decoded(device);
+                            } else if (device->descriptor_available || device->report_plan_valid){
+                                // report plan is valid before the descriptor is available if it was compiled from the cache
+                                hid_host_handle_interrupt_report(device, hid_subevent_report_get_report(packet), hid_subevent_report_get_report_len(packet));
+                                hid_host_first_report_decoded(device);
                             } else {
                                 printf_hexdump(hid_subevent_report_get_report(packet), hid_subevent_report_get_report_len(packet));
                             }
@@ -399,6 +792,8 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
                             // HID Device as requested in the call to hid_host_accept_connection. The event 
                             // reports the result. For connections initiated by calling hid_host_connect, 
                             // this event will occur only if the established report mode is boot mode.
+                            device = hid_host_device_for_cid(hid_subevent_set_protocol_response_get_hid_cid(packet));
+                            if (device == NULL) break;
                             status = hid_subevent_set_protocol_response_get_handshake_status(packet);
                             if (status != HID_HANDSHAKE_PARAM_TYPE_SUCCESSFUL){
                                 printf("Error set protocol, status 0x%02x\n", status);
@@ -407,9 +802,11 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
                             switch ((hid_protocol_mode_t)hid_subevent_set_protocol_response_get_protocol_mode(packet)){
                                 case HID_PROTOCOL_MODE_BOOT:
                                     printf("Protocol mode set: BOOT.\n");
+                                    device->protocol_mode = HID_PROTOCOL_MODE_BOOT;
                                     break;  
                                 case HID_PROTOCOL_MODE_REPORT:
                                     printf("Protocol mode set: REPORT.\n");
+                                    device->protocol_mode = HID_PROTOCOL_MODE_REPORT;
                                     break;
                                 default:
                                     printf("Unknown protocol mode.\n");
@@ -419,9 +816,16 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
 
                         case HID_SUBEVENT_CONNECTION_CLOSED:
                             // The connection was closed.
-                            hid_host_cid = 0;
-                            hid_host_descriptor_available = false;
-                            printf("HID Host disconnected.\n");
+                            hid_cid = hid_subevent_connection_closed_get_hid_cid(packet);
+                            device = hid_host_device_for_cid(hid_cid);
+                            if (device != NULL){
+                                hid_host_device_free(device);
+                            }
+                            printf("HID Host disconnected device 0x%04x.\n", hid_cid);
+#ifdef ENABLE_ACL_TELEMETRY
+                            acl_telemetry_connection_closed(&acl_telemetry);
+                            acl_telemetry_dump(&acl_telemetry);
+#endif
                             break;
                         
                         default:
@@ -444,7 +848,11 @@ static void show_usage(void){
     gap_local_bd_addr(iut_address);
     printf("\n--- Bluetooth HID Host Console %s ---\n", bd_addr_to_str(iut_address));
     printf("c      - Connect to %s in report mode, with fallback to boot mode.\n", remote_addr_string);
-    printf("C      - Disconnect\n");
+    printf("C      - Disconnect all devices\n");
+    printf("m      - Show memory use per device\n");
+#ifdef ENABLE_ACL_TELEMETRY
+    printf("t      - Show ACL telemetry\n");
+#endif
     
     printf("\n");
     printf("Ctrl-c - exit\n");
@@ -453,15 +861,27 @@ static void show_usage(void){
 
 static void stdin_process(char cmd){
     uint8_t status = ERROR_CODE_SUCCESS;
+    int i;
     switch (cmd){
         case 'c':
             printf("Connect to %s in report mode, with fallback to boot mode.\n", remote_addr_string);
-            status = hid_host_connect(remote_addr, hid_host_report_mode, &hid_host_cid);
+            status = hid_host_demo_connect();
             break;
         case 'C':
             printf("Disconnect...\n");
-            hid_host_disconnect(hid_host_cid);
+            for (i = 0; i < MAX_NR_HID_HOST_CONNECTIONS; i++){
+                if (hid_host_devices[i].cid == 0) continue;
+                hid_host_disconnect(hid_host_devices[i].cid);
+            }
             break;
+        case 'm':
+            hid_host_print_memory();
+            break;
+#ifdef ENABLE_ACL_TELEMETRY
+        case 't':
+            acl_telemetry_dump(&acl_telemetry);
+            break;
+#endif
         case '\n':
         case '\r':
             break;
@@ -54,17 +54,93 @@
 #include <inttypes.h>
 
 #include "btstack.h"
+#include "btstack_tlv.h"
 
 // Add Pico SDK GPIO libraries
 #include "hardware/gpio.h"
 #include "pico/stdlib.h"
 
+#include "acl_telemetry.h"
+#include "boot_trace.h"
+#include "hid_keyboard_demo.h"
+#include "key_input.h"
+#include "key_latency.h"
+#include "key_state.h"
+#include "keytable_us.h"
+
+#ifdef ENABLE_KEY_MATRIX
+#include "key_matrix.h"
+#include "key_matrix_pio.h"
+#endif
+
+#ifdef ENABLE_CORE1_INPUT
+#include "pico/multicore.h"
+#endif
+
 // timing of keypresses
 #define TYPING_KEYDOWN_MS  20
 #define TYPING_DELAY_MS    20
 
-// Button debounce time in milliseconds
-#define DEBOUNCE_MS 300
+// Pace typing by CAN_SEND_NOW arrival and sniff interval instead of the fixed delays above
+// #define ENABLE_ADAPTIVE_PACING
+
+// adaptive pacing: minimal time a typed key is held down / released
+#define TYPING_MIN_HOLD_MS  5
+
+// Type a fixed text after connecting and report the achieved chars/s
+// #define ENABLE_TYPING_BENCHMARK
+
+// Leave sniff mode as soon as input starts and request it again after SNIFF_IDLE_MS without input
+// #define ENABLE_SNIFF_MANAGER
+
+// sniff manager: idle time and requested sniff parameters, intervals in 0.625 ms slots
+#define SNIFF_IDLE_MS       2000
+#define SNIFF_MIN_INTERVAL  160     // 100 ms
+#define SNIFF_MAX_INTERVAL  800     // 500 ms
+#define SNIFF_ATTEMPT       4
+#define SNIFF_TIMEOUT       1
+
+// Log every debounced key press and release. printf on the input path adds to the measured latency
+// #define ENABLE_KEY_EVENT_LOG
+
+// Measure latency from debounced key event to report submission, Ctrl-T on stdin prints the histograms
+// #define ENABLE_LATENCY_STATS
+
+// Count ACL buffer usage, CAN_SEND_NOW waits and coalesced reports, printed on disconnect and with Ctrl-T on stdin
+// #define ENABLE_ACL_TELEMETRY
+
+#if defined(ENABLE_LATENCY_STATS) || defined(ENABLE_ACL_TELEMETRY)
+#define ENABLE_STATS_DUMP
+#endif
+
+// Report all held keys as a bitmap (NKRO) instead of the 6 key array
+// #define ENABLE_NKRO_REPORT
+
+// Composite device: mouse and consumer control reports next to the keyboard, sent over the same link
+// #define ENABLE_COMPOSITE
+
+// composite: mouse movement while a direction input is held
+#define MOUSE_MOVE_PERIOD_MS    10
+#define MOUSE_MOVE_STEP         4
+
+// Text waiting to be typed, e.g. from type_string() or stdin
+#define SEND_BUFFER_SIZE 4096
+
+// Text typed with type_string() once a host is connected
+// #define TYPE_ON_CONNECT "Hello from Pico W\n"
+
+// Type text received on stdin (USB CDC), read in blocks as send buffer space becomes available
+// #define ENABLE_STDIN_STREAM
+#define STDIN_BLOCK_SIZE 64
+
+// backpressure relies on USB CDC flow control, UART input would overrun the stdio buffer
+#if defined(ENABLE_STDIN_STREAM) && !defined(LIB_PICO_STDIO_USB)
+#error "ENABLE_STDIN_STREAM needs stdio over USB, see pico_enable_stdio_usb() in CMakeLists.txt"
+#endif
+
+// Buttons are sampled every DEBOUNCE_SAMPLE_US, an edge is accepted after DEBOUNCE_SAMPLES stable samples
+#define DEBOUNCE_SAMPLE_US 1000
+#define DEBOUNCE_SAMPLES   5
 
 // GPIO pins for buttons
 #define GPIO_BUTTON_D 10  // D key
@@ -72,139 +148,279 @@
 #define GPIO_BUTTON_A 21  // A key
 #define GPIO_BUTTON_S 20  // S key
 
-// GPIO pin for status LED
-#define GPIO_STATUS_LED 15  // Status LED
-
-// When not set to 0xffff, sniff and sniff subrating are enabled
-static uint16_t host_max_latency = 1600;
-static uint16_t host_min_timeout = 3200;
+// GPIO pins for composite inputs
+#define GPIO_BUTTON_MOUSE_LEFT      6
+#define GPIO_BUTTON_MOUSE_RIGHT     7
+#define GPIO_BUTTON_MOUSE_UP        8
+#define GPIO_BUTTON_MOUSE_DOWN      9
+#define GPIO_BUTTON_MOUSE_CLICK     12
+#define GPIO_BUTTON_PLAY_PAUSE      13
+#define GPIO_BUTTON_VOLUME_DOWN     18
+#define GPIO_BUTTON_VOLUME_UP       19
 
-#define REPORT_ID 0x01
+// GPIO pins for the multi host switch chord
+#define GPIO_BUTTON_HOST_SWITCH_1   16
+#define GPIO_BUTTON_HOST_SWITCH_2   17
 
-// close to USB HID Specification 1.1, Appendix B.1
-const uint8_t hid_descriptor_keyboard[] = {
+// Use a key matrix scanned by PIO instead of the GPIO buttons above
+// #define ENABLE_KEY_MATRIX
 
-    0x05, 0x01,                    // Usage Page (Generic Desktop)
-    0x09, 0x06,                    // Usage (Keyboard)
-    0xa1, 0x01,                    // Collection (Application)
+// Sample, debounce and compose reports on core1, core0 only sends them
+// #define ENABLE_CORE1_INPUT
 
-    // Report ID
+// Key matrix: rows and columns on consecutive GPIOs, diode per key recommended
+#define MATRIX_ROW_BASE      2      // GP2..GP10
+#define MATRIX_ROWS          9
+#define MATRIX_COL_BASE     16      // GP16..GP22
+#define MATRIX_COLS          7
+#define MATRIX_SCAN_RATE_HZ 4000
 
-    0x85, REPORT_ID,               // Report ID
+// Remember the last bonded host in TLV and reconnect to it on boot, retrying with exponential back-off
+// #define ENABLE_AUTO_RECONNECT
 
-    // Modifier byte (input)
+// auto reconnect: first retry delay, max retry delay and page timeout (0.625 ms slots)
+#define RECONNECT_DELAY_MS      500
+#define RECONNECT_MAX_DELAY_MS  30000
+#define RECONNECT_PAGE_TIMEOUT  0x0c80  // 2 s
 
-    0x75, 0x01,                    //   Report Size (1)
-    0x95, 0x08,                    //   Report Count (8)
-    0x05, 0x07,                    //   Usage Page (Key codes)
-    0x19, 0xe0,                    //   Usage Minimum (Keyboard LeftControl)
-    0x29, 0xe7,                    //   Usage Maximum (Keyboard Right GUI)
-    0x15, 0x00,                    //   Logical Minimum (0)
-    0x25, 0x01,                    //   Logical Maximum (1)
-    0x81, 0x02,                    //   Input (Data, Variable, Absolute)
+// page scan for reconnects initiated by the host: interlaced scan every 320 ms (0.625 ms slots)
+#define PAGE_SCAN_INTERVAL      0x0200
+#define PAGE_SCAN_WINDOW        0x0012
 
-    // Reserved byte (input)
+// Remember up to HOST_SLOTS bonded hosts and switch to the next one by holding both HOST_SWITCH_KEYs
+// #define ENABLE_MULTI_HOST
 
-    0x75, 0x01,                    //   Report Size (1)
-    0x95, 0x08,                    //   Report Count (8)
-    0x81, 0x03,                    //   Input (Constant, Variable, Absolute)
+// multi host: the chord keys are taken from the reserved keycodes and never reported to the host.
+// They are mapped to GPIO buttons and can be used in key_matrix_keymap like keycodes.
+#define HOST_SLOTS          3
+#define HOST_SWITCH_KEY_1   0xe8
+#define HOST_SWITCH_KEY_2   0xe9
 
-    // LED report + padding (output)
+// Skip the second stdio init and the 2 s wait for USB on boot, boot output is replayed once USB is up
+// #define ENABLE_FAST_BOOT
 
-    0x95, 0x05,                    //   Report Count (5)
-    0x75, 0x01,                    //   Report Size (1)
-    0x05, 0x08,                    //   Usage Page (LEDs)
-    0x19, 0x01,                    //   Usage Minimum (Num Lock)
-    0x29, 0x05,                    //   Usage Maximum (Kana)
-    0x91, 0x02,                    //   Output (Data, Variable, Absolute)
+// boot trace is printed after the first connection, or after BOOT_TRACE_TIMEOUT_MS without one
+#define BOOT_TRACE_TIMEOUT_MS   10000
 
-    0x95, 0x01,                    //   Report Count (1)
-    0x75, 0x03,                    //   Report Size (3)
-    0x91, 0x03,                    //   Output (Constant, Variable, Absolute)
+// GPIO pin for status LED
+#define GPIO_STATUS_LED 15  // Status LED
 
-    // Keycodes (input)
+// When not set to 0xffff, sniff and sniff subrating are enabled
+static uint16_t host_max_latency = 1600;
+static uint16_t host_min_timeout = 3200;
 
-    0x95, 0x06,                    //   Report Count (6)
-    0x75, 0x08,                    //   Report Size (8)
-    0x15, 0x00,                    //   Logical Minimum (0)
-    0x25, 0xff,                    //   Logical Maximum (1)
-    0x05, 0x07,                    //   Usage Page (Key codes)
-    0x19, 0x00,                    //   Usage Minimum (Reserved (no event indicated))
-    0x29, 0xff,                    //   Usage Maximum (Reserved)
-    0x81, 0x00,                    //   Input (Data, Array)
+// report IDs and report descriptor, shared with the HID-over-GATT keyboard
+#include "hid_descriptor_keyboard.h"
 
-    0xc0,                          // End collection
-};
+#ifdef ENABLE_NKRO_REPORT
+// input report without report ID: modifier, keycode bitmap
+#define REPORT_PAYLOAD_SIZE (1 + NKRO_BITMAP_SIZE)
+#else
+// input report without report ID: modifier, reserved, keycodes
+#define REPORT_PAYLOAD_SIZE (2 + NUM_KEYS)
+#endif
 
-// 
-#define CHAR_ILLEGAL     0xff
-#define CHAR_RETURN     '\n'
-#define CHAR_ESCAPE      27
-#define CHAR_TAB         '\t'
-#define CHAR_BACKSPACE   0x7f
+#ifdef ENABLE_COMPOSITE
+// Peripheral, Combo Keyboard / Pointing device
+#define HID_DEVICE_SUBCLASS 0x25c0
 
-// Simplified US Keyboard with Shift modifier
+// Mouse and consumer control inputs, taken from the keycodes reserved by the keyboard usage page (0xe8-0xff).
+// They can be used in buttons[] and key_matrix_keymap like keycodes.
+#define INPUT_COMPOSITE_FIRST       0xf0
+#define INPUT_MOUSE_BUTTON_1        0xf0
+#define INPUT_MOUSE_BUTTON_2        0xf1
+#define INPUT_MOUSE_BUTTON_3        0xf2
+#define INPUT_MOUSE_LEFT            0xf4
+#define INPUT_MOUSE_RIGHT           0xf5
+#define INPUT_MOUSE_UP              0xf6
+#define INPUT_MOUSE_DOWN            0xf7
+#define INPUT_CONSUMER_FIRST        0xf8
+#define INPUT_CONSUMER_PLAY_PAUSE   0xf8
+#define INPUT_CONSUMER_MUTE         0xf9
+#define INPUT_CONSUMER_VOLUME_UP    0xfa
+#define INPUT_CONSUMER_VOLUME_DOWN  0xfb
 
-/**
- * English (US)
- */
-static const uint8_t keytable_us_none [] = {
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /*   0-3 */
-    'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j',                   /*  4-13 */
-    'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't',                   /* 14-23 */
-    'u', 'v', 'w', 'x', 'y', 'z',                                       /* 24-29 */
-    '1', '2', '3', '4', '5', '6', '7', '8', '9', '0',                   /* 30-39 */
-    CHAR_RETURN, CHAR_ESCAPE, CHAR_BACKSPACE, CHAR_TAB, ' ',            /* 40-44 */
-    '-', '=', '[', ']', '\\', CHAR_ILLEGAL, ';', '\'', 0x60, ',',       /* 45-54 */
-    '.', '/', CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,   /* 55-60 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 61-64 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 65-68 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 69-72 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 73-76 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 77-80 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 81-84 */
-    '*', '-', '+', '\n', '1', '2', '3', '4', '5',                       /* 85-97 */
-    '6', '7', '8', '9', '0', '.', 0xa7,                                 /* 97-100 */
-}; 
-
-static const uint8_t keytable_us_shift[] = {
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /*  0-3  */
-    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J',                   /*  4-13 */
-    'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T',                   /* 14-23 */
-    'U', 'V', 'W', 'X', 'Y', 'Z',                                       /* 24-29 */
-    '!', '@', '#', '$', '%', '^', '&', '*', '(', ')',                   /* 30-39 */
-    CHAR_RETURN, CHAR_ESCAPE, CHAR_BACKSPACE, CHAR_TAB, ' ',            /* 40-44 */
-    '_', '+', '{', '}', '|', CHAR_ILLEGAL, ':', '"', 0x7E, '<',         /* 45-54 */
-    '>', '?', CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,   /* 55-60 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 61-64 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 65-68 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 69-72 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 73-76 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 77-80 */
-    CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL, CHAR_ILLEGAL,             /* 81-84 */
-    '*', '-', '+', '\n', '1', '2', '3', '4', '5',                       /* 85-97 */
-    '6', '7', '8', '9', '0', '.', 0xb1,                                 /* 97-100 */
-}; 
+// consumer usages, indexed by input - INPUT_CONSUMER_FIRST
+static const uint16_t consumer_usages[] = {
+    0x00cd,     // Play/Pause
+    0x00e2,     // Mute
+    0x00e9,     // Volume Increment
+    0x00ea,     // Volume Decrement
+};
+#else
+// Peripheral, Keyboard
+#define HID_DEVICE_SUBCLASS 0x2540
+#endif
 
 // STATE
 
-static uint8_t hid_service_buffer[300];
+static uint8_t hid_service_buffer[250 + sizeof(hid_descriptor_keyboard)];
 static uint8_t device_id_sdp_service_buffer[100];
 static const char hid_device_name[] = "BTstack HID Keyboard";
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 static uint16_t hid_cid;
+static hci_con_handle_t hid_con_handle = HCI_CON_HANDLE_INVALID;
 static uint8_t hid_boot_device = 0;
 
+static btstack_timer_source_t boot_trace_timer;
+static bool                   boot_trace_printed;
+
 // HID Report sending
-static uint8_t                send_buffer_storage[16];
+static uint8_t                send_buffer_storage[SEND_BUFFER_SIZE];
 static btstack_ring_buffer_t  send_buffer;
 static btstack_timer_source_t send_timer;
-static uint8_t                send_modifier;
+static uint8_t                send_modifier;     // typed key, while it is held down
 static uint8_t                send_keycode;
 static bool                   send_active;
+static bool                   send_typing_report; // typing waits for its key down/up report
+static bool                   send_lookahead;     // next character already read from send_buffer
+static uint8_t                send_lookahead_keycode;
+static uint8_t                send_lookahead_modifier;
+static bool                   send_report_pending;
+static uint32_t               send_buffer_overflows;
+
+// Typing throughput, from first key down until send_buffer runs empty
+static uint32_t               typing_start_ms;
+static uint32_t               typing_chars;
+
+#ifdef ENABLE_TYPING_BENCHMARK
+static const char typing_benchmark_text[] =
+    "The quick brown fox jumps over the lazy dog. THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG!\n"
+    "0123456789 -=[]\\;',./ _+{}|:\"<>? ~`!@#$%^&*()\n";
+static int      typing_benchmark_pos;
+#endif
+
+#ifdef ENABLE_STDIN_STREAM
+static btstack_data_source_t  stdin_stream_data_source;
+static uint32_t               stdin_stream_bytes;
+#endif
+
+// Key state: all keys currently held, sent together in one input report
+static key_state_t            key_state;
+
+#ifdef ENABLE_COMPOSITE
+// Report scheduler: keyboard, mouse and consumer reports share one CAN_SEND_NOW request
+typedef enum {
+    REPORT_TYPE_KEYBOARD = 0,
+    REPORT_TYPE_MOUSE,
+    REPORT_TYPE_CONSUMER,
+    REPORT_TYPE_COUNT
+} report_type_t;
+
+static uint8_t                report_pending_mask;  // bit per report_type_t
+static uint8_t                report_next_type;     // round robin start
+
+// Mouse and consumer control state
+#define MOUSE_DIRECTION_LEFT  0x01
+#define MOUSE_DIRECTION_RIGHT 0x02
+#define MOUSE_DIRECTION_UP    0x04
+#define MOUSE_DIRECTION_DOWN  0x08
+static uint8_t                mouse_buttons;
+static uint8_t                mouse_directions;     // held direction inputs
+static int                    mouse_dx;             // movement not reported yet
+static int                    mouse_dy;
+static btstack_timer_source_t mouse_move_timer;
+static uint16_t               consumer_usage;       // 0 = none
+#endif
 
-// GPIO button debounce timers
-static uint32_t last_button_press_time[4] = {0, 0, 0, 0};
+#ifdef ENABLE_ADAPTIVE_PACING
+// sniff interval of the HID connection, 0 in active mode
+static uint32_t pacing_sniff_interval_ms;
+#endif
+
+#ifdef ENABLE_SNIFF_MANAGER
+static btstack_timer_source_t sniff_idle_timer;
+static bool                   sniff_mode_active;
+static bool                   sniff_exit_pending;
+static uint32_t               sniff_exit_request_ms;  // input activity that triggered sniff exit
+#endif
+
+#ifdef ENABLE_KEY_MATRIX
+
+// Key matrix keycodes, 0 = no key
+static const uint8_t key_matrix_keymap[MATRIX_ROWS][MATRIX_COLS] = {
+    { 0x29, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23 },   // Esc 1 2 3 4 5 6
+    { 0x24, 0x25, 0x26, 0x27, 0x2d, 0x2e, 0x2a },   // 7 8 9 0 - = Backspace
+    { 0x2b, 0x14, 0x1a, 0x08, 0x15, 0x17, 0x1c },   // Tab q w e r t y
+    { 0x18, 0x0c, 0x12, 0x13, 0x2f, 0x30, 0x31 },   // u i o p [ ] '\'
+    { 0x39, 0x04, 0x16, 0x07, 0x09, 0x0a, 0x0b },   // CapsLock a s d f g h
+    { 0x0d, 0x0e, 0x0f, 0x33, 0x34, 0x28, 0xe1 },   // j k l ; ' Enter LeftShift
+    { 0x1d, 0x1b, 0x06, 0x19, 0x05, 0x11, 0x10 },   // z x c v b n m
+    { 0x36, 0x37, 0x38, 0xe5, 0xe0, 0xe3, 0xe2 },   // , . / RightShift LeftCtrl LeftGUI LeftAlt
+    { 0x2c, 0xe6, 0xe4, 0x50, 0x51, 0x52, 0x4f },   // Space RightAlt RightCtrl Left Down Up Right
+};
+
+static key_matrix_t      key_matrix;
+
+#else
+
+// GPIO buttons, active low
+static const key_input_button_t buttons[] = {
+    { GPIO_BUTTON_D, 0x07 },    // d
+    { GPIO_BUTTON_W, 0x1a },    // w
+    { GPIO_BUTTON_A, 0x04 },    // a
+    { GPIO_BUTTON_S, 0x16 },    // s
+#ifdef ENABLE_COMPOSITE
+    { GPIO_BUTTON_MOUSE_LEFT,   INPUT_MOUSE_LEFT },
+    { GPIO_BUTTON_MOUSE_RIGHT,  INPUT_MOUSE_RIGHT },
+    { GPIO_BUTTON_MOUSE_UP,     INPUT_MOUSE_UP },
+    { GPIO_BUTTON_MOUSE_DOWN,   INPUT_MOUSE_DOWN },
+    { GPIO_BUTTON_MOUSE_CLICK,  INPUT_MOUSE_BUTTON_1 },
+    { GPIO_BUTTON_PLAY_PAUSE,   INPUT_CONSUMER_PLAY_PAUSE },
+    { GPIO_BUTTON_VOLUME_DOWN,  INPUT_CONSUMER_VOLUME_DOWN },
+    { GPIO_BUTTON_VOLUME_UP,    INPUT_CONSUMER_VOLUME_UP },
+#endif
+#ifdef ENABLE_MULTI_HOST
+    { GPIO_BUTTON_HOST_SWITCH_1, HOST_SWITCH_KEY_1 },
+    { GPIO_BUTTON_HOST_SWITCH_2, HOST_SWITCH_KEY_2 },
+#endif
+};
+
+#define NUM_BUTTONS (sizeof(buttons) / sizeof(key_input_button_t))
+
+static key_input_buttons_t key_input_buttons;
+
+#endif
+
+// pressing this key while not connected connects to device_addr
+#define CONNECT_KEYCODE 0x07    // d
+
+// Key events from interrupt context (or core1), processed on the run loop
+typedef struct {
+    uint8_t keycode;
+    bool    pressed;
+#ifdef ENABLE_CORE1_INPUT
+    uint8_t payload[REPORT_PAYLOAD_SIZE];   // held keys after this event, composed on core1
+#endif
+#ifdef ENABLE_LATENCY_STATS
+    uint32_t timestamp_us;                  // time_us_32() when posted
+#endif
+} key_event_t;
+
+#define KEY_EVENT_QUEUE_SIZE 32     // power of two
+static key_event_t          key_event_storage[KEY_EVENT_QUEUE_SIZE];
+static key_input_queue_t    key_event_queue;
+
+#ifdef ENABLE_CORE1_INPUT
+// held keys from the last key event, key_state is owned by core1
+static uint8_t input_report_payload[REPORT_PAYLOAD_SIZE];
+#endif
+
+#ifdef ENABLE_LATENCY_STATS
+static key_latency_t key_latency;
+#endif
+
+#ifdef ENABLE_ACL_TELEMETRY
+static acl_telemetry_t acl_telemetry;
+#endif
+
+#ifdef ENABLE_STATS_DUMP
+#define CHAR_DUMP_STATS 0x14    // Ctrl-T
+#endif
+
+#if defined(ENABLE_STATS_DUMP) && !defined(ENABLE_STDIN_STREAM)
+static btstack_data_source_t stdin_command_data_source;
+#endif
 
 static bd_addr_t device_addr;
 static const char * device_addr_string = "BC:EC:5D:E6:15:03"; // Target device address
@@ -216,6 +432,30 @@ static enum {
     APP_CONNECTED
 } app_state = APP_BOOTING;
 
+#ifdef ENABLE_AUTO_RECONNECT
+// TLV tag for the address of the last bonded host
+#define TLV_TAG_LAST_HOST (((uint32_t) 'H' << 24) | ((uint32_t) 'I' << 16) | ((uint32_t) 'D' << 8) | 'H')
+
+static btstack_timer_source_t reconnect_timer;
+static bool                   reconnect_active;
+static uint32_t               reconnect_delay_ms;
+static uint16_t               reconnect_attempts;
+static bool                   reconnect_boot_time_reported;
+#endif
+
+#ifdef ENABLE_MULTI_HOST
+// TLV tags for the addresses of the bonded hosts, one per slot
+#define TLV_TAG_HOST_SLOT(slot) (((uint32_t) 'H' << 24) | ((uint32_t) 'S' << 16) | ((uint32_t) 'L' << 8) | ('0' + (slot)))
+
+static bd_addr_t host_slot_addr[HOST_SLOTS];
+static bool      host_slot_valid[HOST_SLOTS];
+static uint8_t   host_slot_active;
+static bool      host_switch_pending;       // connect to active slot once the current connection is closed
+static bool      host_switch_timing;
+static uint32_t  host_switch_start_ms;
+static uint8_t   host_switch_keys_held;     // bit 0: HOST_SWITCH_KEY_1, bit 1: HOST_SWITCH_KEY_2
+#endif
+
 // Function to update LED status based on connection state
 static void update_status_led(void) {
     if (app_state == APP_CONNECTED) {
@@ -227,122 +467,903 @@ static void update_status_led(void) {
     }
 }
 
-// HID Keyboard lookup
-static bool lookup_keycode(uint8_t character, const uint8_t * table, int size, uint8_t * keycode){
+#if defined(ENABLE_AUTO_RECONNECT) || defined(ENABLE_MULTI_HOST)
+// load address stored under tag, returns false if none is stored
+static bool tlv_addr_load(uint32_t tag, bd_addr_t addr){
+    const btstack_tlv_t * tlv_impl;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl == NULL) return false;
+    return tlv_impl->get_tag(tlv_context, tag, addr, sizeof(bd_addr_t)) == sizeof(bd_addr_t);
+}
+
+// store address under tag, flash is only written if it changed. Returns true if written
+static bool tlv_addr_store(uint32_t tag, const bd_addr_t addr){
+    bd_addr_t stored_addr;
+    if (tlv_addr_load(tag, stored_addr) && (bd_addr_cmp(stored_addr, addr) == 0)) return false;
+    const btstack_tlv_t * tlv_impl;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl == NULL) return false;
+    tlv_impl->store_tag(tlv_context, tag, (const uint8_t *) addr, sizeof(bd_addr_t));
+    return true;
+}
+
+static bool host_is_bonded(const bd_addr_t addr){
+    link_key_t link_key;
+    link_key_type_t link_key_type;
+    return gap_get_link_key_for_bd_addr((uint8_t *) addr, link_key, &link_key_type) != 0;
+}
+#endif
+
+#ifdef ENABLE_MULTI_HOST
+static void host_slots_load(void){
+    int i;
+    for (i = 0; i < HOST_SLOTS; i++){
+        host_slot_valid[i] = tlv_addr_load(TLV_TAG_HOST_SLOT(i), host_slot_addr[i]);
+        if (host_slot_valid[i]){
+            printf("Host %u: %s\n", i + 1, bd_addr_to_str(host_slot_addr[i]));
+        }
+    }
+}
+
+// a bonded host connected: its slot becomes active, a new host takes a free slot or replaces the active one
+static void host_slots_connected(const bd_addr_t addr){
+    if (host_switch_timing){
+        host_switch_timing = false;
+        printf("Host switch took %u ms\n", btstack_run_loop_get_time_ms() - host_switch_start_ms);
+    }
+    if (host_is_bonded(addr) == false) return;
+    int slot = -1;
     int i;
-    for (i=0;i<size;i++){
-        if (table[i] != character) continue;
-        *keycode = i;
+    for (i = 0; i < HOST_SLOTS; i++){
+        if (host_slot_valid[i] && (bd_addr_cmp(host_slot_addr[i], addr) == 0)){
+            host_slot_active = (uint8_t) i;
+            return;
+        }
+        if ((slot < 0) && (host_slot_valid[i] == false)){
+            slot = i;
+        }
+    }
+    if (slot < 0){
+        slot = host_slot_active;
+    }
+    host_slot_active = (uint8_t) slot;
+    bd_addr_copy(host_slot_addr[slot], addr);
+    host_slot_valid[slot] = true;
+    tlv_addr_store(TLV_TAG_HOST_SLOT(slot), addr);
+    printf("Host %u: %s\n", slot + 1, bd_addr_to_str(addr));
+}
+
+static void host_switch_connect(void){
+    host_switch_pending = false;
+    bd_addr_copy(device_addr, host_slot_addr[host_slot_active]);
+    printf("Connecting to host %u (%s)\n", host_slot_active + 1, bd_addr_to_str(device_addr));
+    if (hid_device_connect(device_addr, &hid_cid) != ERROR_CODE_SUCCESS) return;
+    app_state = APP_CONNECTING;
+}
+
+// hid_device serves a single HID connection, so the current one is closed before connecting to the next host.
+// If the ACL link to the next host is still up, e.g. shortly after switching away from it, paging is skipped.
+static void host_switch_next(void){
+    if (app_state == APP_CONNECTING) return;
+    int i;
+    for (i = 1; i < HOST_SLOTS; i++){
+        uint8_t slot = (uint8_t) ((host_slot_active + i) % HOST_SLOTS);
+        if (host_slot_valid[slot] == false) continue;
+        host_slot_active = slot;
+        host_switch_timing = true;
+        host_switch_start_ms = btstack_run_loop_get_time_ms();
+        if (app_state == APP_CONNECTED){
+            host_switch_pending = true;
+            hid_device_disconnect(hid_cid);
+        } else {
+            host_switch_connect();
+        }
+        return;
+    }
+    printf("No other host to switch to\n");
+}
+
+// track chord keys and switch once both are held, returns false if keycode is not a chord key
+static bool host_switch_chord(uint8_t keycode, bool pressed){
+    uint8_t bit;
+    if (keycode == HOST_SWITCH_KEY_1){
+        bit = 1;
+    } else if (keycode == HOST_SWITCH_KEY_2){
+        bit = 2;
+    } else {
+        return false;
+    }
+    if (pressed == false){
+        host_switch_keys_held &= ~bit;
         return true;
     }
-    return false;
+    host_switch_keys_held |= bit;
+    if (host_switch_keys_held == 3){
+        host_switch_next();
+    }
+    return true;
+}
+#endif
+
+#ifdef ENABLE_AUTO_RECONNECT
+// load address of the last bonded host, returns false if none is stored
+static bool last_host_load(bd_addr_t addr){
+    return tlv_addr_load(TLV_TAG_LAST_HOST, addr);
+}
+
+// store address of a bonded host
+static void last_host_store(const bd_addr_t addr){
+    if (host_is_bonded(addr) == false) return;
+    if (tlv_addr_store(TLV_TAG_LAST_HOST, addr) == false) return;
+    printf("Remember %s as last host\n", bd_addr_to_str(addr));
+}
+
+static void reconnect_handler(btstack_timer_source_t * ts);
+
+// retry with exponential back-off
+static void reconnect_failed(void){
+    if (reconnect_active == false) return;
+    printf("Reconnect failed, retry in %u ms\n", reconnect_delay_ms);
+    btstack_run_loop_set_timer_handler(&reconnect_timer, &reconnect_handler);
+    btstack_run_loop_set_timer(&reconnect_timer, reconnect_delay_ms);
+    btstack_run_loop_add_timer(&reconnect_timer);
+    reconnect_delay_ms *= 2;
+    if (reconnect_delay_ms > RECONNECT_MAX_DELAY_MS){
+        reconnect_delay_ms = RECONNECT_MAX_DELAY_MS;
+    }
 }
 
+static void reconnect_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    if (reconnect_active == false) return;
+    if (app_state != APP_NOT_CONNECTED) return;
+    reconnect_attempts++;
+    printf("Reconnect to %s, attempt %u\n", bd_addr_to_str(device_addr), reconnect_attempts);
+    if (hid_device_connect(device_addr, &hid_cid) != ERROR_CODE_SUCCESS){
+        reconnect_failed();
+        return;
+    }
+    app_state = APP_CONNECTING;
+}
+
+// reconnect to last host right away, if there is one
+static void reconnect_start(void){
+    if (last_host_load(device_addr) == false){
+        printf("No host remembered. Press button D to connect or pair.\n");
+        return;
+    }
+    reconnect_active = true;
+    reconnect_delay_ms = RECONNECT_DELAY_MS;
+    reconnect_attempts = 0;
+    reconnect_handler(&reconnect_timer);
+}
+
+static void reconnect_connected(const bd_addr_t addr){
+    if (reconnect_boot_time_reported == false){
+        reconnect_boot_time_reported = true;
+        printf("Connected %u ms after power-on, %u reconnect attempts\n",
+               to_ms_since_boot(get_absolute_time()), reconnect_attempts);
+    }
+    reconnect_active = false;
+    btstack_run_loop_remove_timer(&reconnect_timer);
+    last_host_store(addr);
+}
+#endif
+
+// HID Keyboard lookup
 static bool keycode_and_modifer_us_for_character(uint8_t character, uint8_t * keycode, uint8_t * modifier){
-    bool found;
-    found = lookup_keycode(character, keytable_us_none, sizeof(keytable_us_none), keycode);
-    if (found) {
-        *modifier = 0;  // none
-        return true;
+    return keytable_us_lookup(character, keycode, modifier);
+}
+
+// compose input report payload from held keys
+static void report_payload_compose(uint8_t * payload){
+#ifdef ENABLE_NKRO_REPORT
+    key_state_compose_bitmap(&key_state, payload, NKRO_BITMAP_SIZE);
+#else
+    key_state_compose_keys(&key_state, payload, NUM_KEYS);
+#endif
+}
+
+// add typed key to input report payload (keycode 0 = none)
+static void report_payload_add_key(uint8_t * payload, uint8_t modifier, uint8_t keycode){
+    payload[0] |= modifier;
+    if (keycode == 0) return;
+#ifdef ENABLE_NKRO_REPORT
+    if (keycode < NKRO_NUM_KEYCODES){
+        payload[1 + (keycode >> 3)] |= 1 << (keycode & 0x07);
     }
-    found = lookup_keycode(character, keytable_us_shift, sizeof(keytable_us_shift), keycode);
-    if (found) {
-        *modifier = 2;  // shift
-        return true;
+#else
+    int i;
+    for (i = 0; i < NUM_KEYS; i++){
+        uint8_t held_keycode = payload[2 + i];
+        // already held, or ErrorRollOver
+        if (held_keycode == keycode || held_keycode == 0x01) return;
+        if (held_keycode == 0){
+            payload[2 + i] = keycode;
+            return;
+        }
     }
-    return false;
+    memset(&payload[2], 0x01, NUM_KEYS);
+#endif
 }
 
-static void send_report(int modifier, int keycode){
+// send held keys together with the typed key (keycode 0 = none)
+static void send_report(uint8_t modifier, uint8_t keycode){
     // setup HID message: A1 = Input Report, Report ID, Payload
-    uint8_t message[] = {0xa1, REPORT_ID, modifier, 0, keycode, 0, 0, 0, 0, 0};
+    uint8_t message[2 + REPORT_PAYLOAD_SIZE];
+    message[0] = 0xa1;
+#ifdef ENABLE_NKRO_REPORT
+    message[1] = REPORT_ID_NKRO;
+#else
+    message[1] = REPORT_ID;
+#endif
+#ifdef ENABLE_CORE1_INPUT
+    // held keys were composed on core1
+    memcpy(&message[2], input_report_payload, REPORT_PAYLOAD_SIZE);
+#else
+    report_payload_compose(&message[2]);
+#endif
+    report_payload_add_key(&message[2], modifier, keycode);
     hid_device_send_interrupt_message(hid_cid, &message[0], sizeof(message));
+#ifdef ENABLE_ACL_TELEMETRY
+    acl_telemetry_report_sent(&acl_telemetry, hid_con_handle);
+#endif
+#ifdef ENABLE_LATENCY_STATS
+    key_latency_report_sent(&key_latency, time_us_32());
+#endif
 }
 
-static void trigger_key_up(btstack_timer_source_t * ts){
+#ifdef ENABLE_SNIFF_MANAGER
+static void sniff_idle_handler(btstack_timer_source_t * ts){
     UNUSED(ts);
+    if (hid_con_handle == HCI_CON_HANDLE_INVALID) return;
+    if (sniff_mode_active) return;
+    printf("Sniff manager: idle for %u ms, requesting sniff mode\n", SNIFF_IDLE_MS);
+    gap_sniff_mode_enter(hid_con_handle, SNIFF_MIN_INTERVAL, SNIFF_MAX_INTERVAL, SNIFF_ATTEMPT, SNIFF_TIMEOUT);
+}
+
+// input activity: leave sniff mode right away, keep active mode until SNIFF_IDLE_MS without activity
+static void sniff_manager_activity(void){
+    if (hid_con_handle == HCI_CON_HANDLE_INVALID) return;
+    if (sniff_mode_active && (sniff_exit_pending == false)){
+        sniff_exit_pending = true;
+        sniff_exit_request_ms = btstack_run_loop_get_time_ms();
+        gap_sniff_mode_exit(hid_con_handle);
+    }
+    btstack_run_loop_remove_timer(&sniff_idle_timer);
+    btstack_run_loop_set_timer_handler(&sniff_idle_timer, &sniff_idle_handler);
+    btstack_run_loop_set_timer(&sniff_idle_timer, SNIFF_IDLE_MS);
+    btstack_run_loop_add_timer(&sniff_idle_timer);
+}
+
+// sniff interval is in 0.625 ms slots
+static void sniff_manager_mode_change(uint8_t mode, uint16_t interval){
+    if (mode == 0x02){   // Sniff Mode
+        sniff_mode_active = true;
+        printf("Sniff manager: sniff mode, interval %u ms\n", interval * 625 / 1000);
+        if (host_max_latency != 0xffff){
+            gap_sniff_subrating_configure(hid_con_handle, host_max_latency, host_min_timeout, host_min_timeout);
+        }
+    } else {
+        sniff_mode_active = false;
+        if (sniff_exit_pending){
+            printf("Sniff manager: active mode, %u ms after input\n", btstack_run_loop_get_time_ms() - sniff_exit_request_ms);
+        } else {
+            printf("Sniff manager: active mode\n");
+        }
+    }
+    sniff_exit_pending = false;
+}
+
+static void sniff_manager_reset(void){
+    btstack_run_loop_remove_timer(&sniff_idle_timer);
+    sniff_mode_active = false;
+    sniff_exit_pending = false;
+}
+#endif
+
+static void request_can_send_now(void){
+    send_report_pending = true;
+#ifdef ENABLE_LATENCY_STATS
+    key_latency_report_requested(&key_latency, time_us_32());
+#endif
     hid_device_request_can_send_now_event(hid_cid);
+#ifdef ENABLE_ACL_TELEMETRY
+    acl_telemetry_can_send_now_requested(&acl_telemetry, hid_con_handle);
+#endif
+}
+
+#ifdef ENABLE_COMPOSITE
+// mark report as pending, it is sent on one of the next CAN_SEND_NOW events with the state at that time
+static void report_schedule(report_type_t type){
+#ifdef ENABLE_SNIFF_MANAGER
+    sniff_manager_activity();
+#endif
+    uint8_t mask = 1 << type;
+    if (report_pending_mask & mask){
+#ifdef ENABLE_ACL_TELEMETRY
+        acl_telemetry_report_coalesced(&acl_telemetry);
+#endif
+        return;
+    }
+    report_pending_mask |= mask;
+    if (send_report_pending) return;
+    request_can_send_now();
+}
+
+// take next pending report round robin, so that continuous mouse movement cannot hold back key presses.
+// Returns REPORT_TYPE_COUNT if none is pending
+static report_type_t report_schedule_next(void){
+    int i;
+    for (i = 0; i < REPORT_TYPE_COUNT; i++){
+        report_type_t type = (report_type_t) ((report_next_type + i) % REPORT_TYPE_COUNT);
+        if (report_pending_mask & (1 << type)){
+            report_pending_mask &= ~(1 << type);
+            report_next_type = (uint8_t) ((type + 1) % REPORT_TYPE_COUNT);
+            return type;
+        }
+    }
+    return REPORT_TYPE_COUNT;
+}
+#endif
+
+// request CAN_SEND_NOW, the report sent then reflects all changes up to that point
+static void request_report(void){
+#ifdef ENABLE_COMPOSITE
+    report_schedule(REPORT_TYPE_KEYBOARD);
+#else
+#ifdef ENABLE_SNIFF_MANAGER
+    sniff_manager_activity();
+#endif
+    if (send_report_pending){
+#ifdef ENABLE_ACL_TELEMETRY
+        acl_telemetry_report_coalesced(&acl_telemetry);
+#endif
+        return;
+    }
+    request_can_send_now();
+#endif
+}
+
+#ifdef ENABLE_COMPOSITE
+static int8_t mouse_clamp(int value){
+    if (value < -127) return -127;
+    if (value >  127) return  127;
+    return (int8_t) value;
+}
+
+// report buttons and movement accumulated since the last mouse report
+static void mouse_send_report(void){
+    int8_t dx = mouse_clamp(mouse_dx);
+    int8_t dy = mouse_clamp(mouse_dy);
+    // setup HID message: A1 = Input Report, Report ID, Payload
+    uint8_t message[] = { 0xa1, REPORT_ID_MOUSE, mouse_buttons, (uint8_t) dx, (uint8_t) dy };
+    hid_device_send_interrupt_message(hid_cid, &message[0], sizeof(message));
+#ifdef ENABLE_ACL_TELEMETRY
+    acl_telemetry_report_sent(&acl_telemetry, hid_con_handle);
+#endif
+    // movement beyond one report goes into the next one
+    mouse_dx -= dx;
+    mouse_dy -= dy;
+    if (mouse_dx || mouse_dy){
+        report_schedule(REPORT_TYPE_MOUSE);
+    }
+}
+
+static void consumer_send_report(void){
+    // setup HID message: A1 = Input Report, Report ID, Payload
+    uint8_t message[] = { 0xa1, REPORT_ID_CONSUMER, (uint8_t) (consumer_usage & 0xff), (uint8_t) (consumer_usage >> 8) };
+    hid_device_send_interrupt_message(hid_cid, &message[0], sizeof(message));
+#ifdef ENABLE_ACL_TELEMETRY
+    acl_telemetry_report_sent(&acl_telemetry, hid_con_handle);
+#endif
+}
+
+static void mouse_move_handler(btstack_timer_source_t * ts){
+    if (mouse_directions == 0) return;
+    if (mouse_directions & MOUSE_DIRECTION_LEFT)  mouse_dx -= MOUSE_MOVE_STEP;
+    if (mouse_directions & MOUSE_DIRECTION_RIGHT) mouse_dx += MOUSE_MOVE_STEP;
+    if (mouse_directions & MOUSE_DIRECTION_UP)    mouse_dy -= MOUSE_MOVE_STEP;
+    if (mouse_directions & MOUSE_DIRECTION_DOWN)  mouse_dy += MOUSE_MOVE_STEP;
+    report_schedule(REPORT_TYPE_MOUSE);
+    btstack_run_loop_set_timer(ts, MOUSE_MOVE_PERIOD_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+// mouse or consumer control input pressed or released
+static void composite_input(uint8_t input, bool pressed){
+    if (input >= INPUT_CONSUMER_FIRST){
+        uint8_t index = input - INPUT_CONSUMER_FIRST;
+        if (index >= sizeof(consumer_usages) / sizeof(uint16_t)) return;
+        uint16_t usage = consumer_usages[index];
+        if (pressed){
+            consumer_usage = usage;
+        } else if (consumer_usage == usage){
+            consumer_usage = 0;
+        } else {
+            return;
+        }
+        report_schedule(REPORT_TYPE_CONSUMER);
+        return;
+    }
+    uint8_t bit;
+    switch (input){
+        case INPUT_MOUSE_BUTTON_1:
+        case INPUT_MOUSE_BUTTON_2:
+        case INPUT_MOUSE_BUTTON_3:
+            bit = 1 << (input - INPUT_MOUSE_BUTTON_1);
+            if (pressed){
+                mouse_buttons |= bit;
+            } else {
+                mouse_buttons &= ~bit;
+            }
+            report_schedule(REPORT_TYPE_MOUSE);
+            return;
+        case INPUT_MOUSE_LEFT:
+            bit = MOUSE_DIRECTION_LEFT;
+            break;
+        case INPUT_MOUSE_RIGHT:
+            bit = MOUSE_DIRECTION_RIGHT;
+            break;
+        case INPUT_MOUSE_UP:
+            bit = MOUSE_DIRECTION_UP;
+            break;
+        case INPUT_MOUSE_DOWN:
+            bit = MOUSE_DIRECTION_DOWN;
+            break;
+        default:
+            return;
+    }
+    if (pressed){
+        // first direction starts moving right away
+        if (mouse_directions == 0){
+            mouse_directions = bit;
+            btstack_run_loop_set_timer_handler(&mouse_move_timer, &mouse_move_handler);
+            mouse_move_handler(&mouse_move_timer);
+            return;
+        }
+        mouse_directions |= bit;
+    } else {
+        mouse_directions &= ~bit;
+        if (mouse_directions == 0){
+            btstack_run_loop_remove_timer(&mouse_move_timer);
+        }
+    }
+}
+
+static void composite_reset(void){
+    btstack_run_loop_remove_timer(&mouse_move_timer);
+    report_pending_mask = 0;
+    mouse_buttons = 0;
+    mouse_directions = 0;
+    mouse_dx = 0;
+    mouse_dy = 0;
+    consumer_usage = 0;
+}
+#endif
+
+#ifdef ENABLE_STATS_DUMP
+static void stats_dump(void){
+#ifdef ENABLE_LATENCY_STATS
+    key_latency_dump(&key_latency, "Classic");
+#endif
+#ifdef ENABLE_ACL_TELEMETRY
+    acl_telemetry_dump(&acl_telemetry);
+#endif
+}
+#endif
+
+// copy as much text into send_buffer as fits, returns number of bytes taken
+static uint32_t send_buffer_fill(const char * text, uint32_t len){
+    uint32_t bytes_free = btstack_ring_buffer_bytes_free(&send_buffer);
+    if (len > bytes_free){
+        len = bytes_free;
+    }
+    if (len > 0){
+        btstack_ring_buffer_write(&send_buffer, (uint8_t *) text, len);
+    }
+    return len;
+}
+
+#ifdef ENABLE_TYPING_BENCHMARK
+// feed benchmark text into send_buffer as space becomes available
+static void typing_benchmark_fill(void){
+    const char * text = &typing_benchmark_text[typing_benchmark_pos];
+    typing_benchmark_pos += send_buffer_fill(text, strlen(text));
+}
+#endif
+
+#ifdef ENABLE_STDIN_STREAM
+// read stdin in blocks while send_buffer has space. Input that doesn't fit stays in the
+// USB CDC FIFO and the host stops sending once that is full, so no bytes get lost.
+static void stdin_stream_fill(void){
+    while (true){
+        char block[STDIN_BLOCK_SIZE];
+        uint32_t bytes_free = btstack_ring_buffer_bytes_free(&send_buffer);
+        int len = (int) btstack_min(bytes_free, sizeof(block));
+        if (len == 0) return;
+        // non-blocking
+        len = stdio_get_until(block, len, get_absolute_time());
+        if (len <= 0) return;
+        stdin_stream_bytes += len;
+#ifdef ENABLE_STATS_DUMP
+        // Ctrl-T has no key, so it is skipped when typing
+        if (memchr(block, CHAR_DUMP_STATS, len) != NULL){
+            stats_dump();
+        }
+#endif
+        send_buffer_fill(block, len);
+    }
+}
+#endif
+
+static void typing_throughput_report(void){
+    uint32_t duration_ms = btstack_run_loop_get_time_ms() - typing_start_ms;
+    if (duration_ms == 0) return;
+    printf("Typed %u chars in %u ms, %u.%u chars/s\n", typing_chars, duration_ms,
+           typing_chars * 1000 / duration_ms, (typing_chars * 10000 / duration_ms) % 10);
+#ifdef ENABLE_STDIN_STREAM
+    printf("Stdin stream: %u bytes received\n", stdin_stream_bytes);
+#endif
+}
+
+// get next typeable character, either the one read ahead or the next one from send_buffer
+static bool typing_get_next(uint8_t * keycode, uint8_t * modifier){
+    if (send_lookahead){
+        send_lookahead = false;
+        *keycode  = send_lookahead_keycode;
+        *modifier = send_lookahead_modifier;
+        return true;
+    }
+#ifdef ENABLE_TYPING_BENCHMARK
+    typing_benchmark_fill();
+#endif
+#ifdef ENABLE_STDIN_STREAM
+    stdin_stream_fill();
+#endif
+    while (true){
+        uint8_t character;
+        uint32_t num_bytes_read = 0;
+        btstack_ring_buffer_read(&send_buffer, &character, 1, &num_bytes_read);
+        if (num_bytes_read == 0) return false;
+        // lookup keycode and modifier using US layout, skip characters without a key
+        if (keycode_and_modifer_us_for_character(character, keycode, modifier)) return true;
+    }
+}
+
+static void trigger_key_up(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    uint8_t keycode;
+    uint8_t modifier;
+    if (typing_get_next(&keycode, &modifier)){
+        if ((keycode != send_keycode) && (modifier == send_modifier)){
+            // release current key and press the next one in the same report
+            send_keycode = keycode;
+            send_typing_report = true;
+            request_report();
+            return;
+        }
+        // same key again or modifier change: needs a full key up first
+        send_lookahead = true;
+        send_lookahead_keycode  = keycode;
+        send_lookahead_modifier = modifier;
+    }
+    send_keycode = 0;
+    send_modifier = 0;
+    send_typing_report = true;
+    request_report();
 }
 
 static void send_next(btstack_timer_source_t * ts) {
-    // get next key from buffer
-    uint8_t character;
-    uint32_t num_bytes_read = 0;
-    btstack_ring_buffer_read(&send_buffer, &character, 1, &num_bytes_read);
-    if (num_bytes_read == 0) {
+    UNUSED(ts);
+    // get next key
+    if (typing_get_next(&send_keycode, &send_modifier) == false) {
         // buffer empty, nothing to send
+        if (send_active){
+            typing_throughput_report();
+        }
         send_active = false;
+        return;
+    }
+    if (send_active == false){
+        typing_start_ms = btstack_run_loop_get_time_ms();
+        typing_chars = 0;
+    }
+    send_active = true;
+    // request can send now
+    send_typing_report = true;
+    request_report();
+}
+
+#ifdef ENABLE_ADAPTIVE_PACING
+// Time until the next typing report is requested, counted from CAN_SEND_NOW of the current one.
+// While the link is busy, CAN_SEND_NOW itself arrives later, so a congested link slows typing down
+// and no reports pile up in the controller's ACL buffers.
+static uint32_t pacing_delay_ms(void){
+    uint32_t delay_ms = TYPING_MIN_HOLD_MS;
+    // in sniff mode, the controller only sends at each anchor point: spread reports over the interval
+    // so that a single anchor point doesn't need more than MAX_NR_CONTROLLER_ACL_BUFFERS
+    uint32_t sniff_share_ms = pacing_sniff_interval_ms / MAX_NR_CONTROLLER_ACL_BUFFERS;
+    if (sniff_share_ms > delay_ms){
+        delay_ms = sniff_share_ms;
+    }
+    return delay_ms;
+}
+#endif
+
+// typed key down or key up was sent, schedule the next step
+static void typing_report_sent(void){
+    if (send_keycode){
+        typing_chars++;
+        // schedule key up
+        btstack_run_loop_set_timer_handler(&send_timer, trigger_key_up);
+#ifdef ENABLE_ADAPTIVE_PACING
+        btstack_run_loop_set_timer(&send_timer, pacing_delay_ms());
+#else
+        btstack_run_loop_set_timer(&send_timer, TYPING_KEYDOWN_MS);
+#endif
     } else {
-        send_active = true;
-        // lookup keycode and modifier using US layout
-        bool found = keycode_and_modifer_us_for_character(character, &send_keycode, &send_modifier);
-        if (found) {
-            // request can send now
-            hid_device_request_can_send_now_event(hid_cid);
-        } else {
-            // restart timer for next character
-            btstack_run_loop_set_timer(ts, TYPING_DELAY_MS);
-            btstack_run_loop_add_timer(ts);
-        }
+        // schedule next key down
+        btstack_run_loop_set_timer_handler(&send_timer, send_next);
+#ifdef ENABLE_ADAPTIVE_PACING
+        btstack_run_loop_set_timer(&send_timer, pacing_delay_ms());
+#else
+        btstack_run_loop_set_timer(&send_timer, TYPING_DELAY_MS);
+#endif
+    }
+    btstack_run_loop_add_timer(&send_timer);
+}
+
+static void keyboard_report_send(void){
+    send_report(send_modifier, send_keycode);
+    if (send_typing_report){
+        send_typing_report = false;
+        typing_report_sent();
+    }
+}
+
+static void hid_keyboard_can_send_now(void){
+    send_report_pending = false;
+#ifdef ENABLE_ACL_TELEMETRY
+    acl_telemetry_can_send_now(&acl_telemetry);
+#endif
+#ifdef ENABLE_LATENCY_STATS
+    key_latency_can_send_now(&key_latency, time_us_32());
+#endif
+#ifdef ENABLE_COMPOSITE
+    // one report per CAN_SEND_NOW
+    switch (report_schedule_next()){
+        case REPORT_TYPE_KEYBOARD:
+            keyboard_report_send();
+            break;
+        case REPORT_TYPE_MOUSE:
+            mouse_send_report();
+            break;
+        case REPORT_TYPE_CONSUMER:
+            consumer_send_report();
+            break;
+        default:
+            break;
+    }
+    // remaining reports go out on the next one
+    if (report_pending_mask && (send_report_pending == false)){
+        request_can_send_now();
     }
+#else
+    keyboard_report_send();
+#endif
+}
+
+// start typing if connected and idle
+static void typing_start(void){
+    if (app_state != APP_CONNECTED) return;
+    if (send_active) return;
+    send_next(&send_timer);
 }
 
 static void queue_character(char character){
-    btstack_ring_buffer_write(&send_buffer, (uint8_t *) &character, 1);
-    if (send_active == false) {
-        send_next(&send_timer);
-    }
-}
-
-// GPIO interrupt handler for buttons
-void gpio_callback(uint gpio, uint32_t events) {
-    // Only process on falling edge (button press)
-    if (events & GPIO_IRQ_EDGE_FALL) {
-        // Get current time for debouncing
-        uint32_t current_time = to_ms_since_boot(get_absolute_time());
-        uint8_t button_index;
-        char key_to_send = 0;
-        
-        // Map GPIO to array index and key character
-        switch(gpio) {
-            case GPIO_BUTTON_D:
-                button_index = 0;
-                key_to_send = 'd';
-                break;
-            case GPIO_BUTTON_W:
-                button_index = 1;
-                key_to_send = 'w';
-                break;
-            case GPIO_BUTTON_A:
-                button_index = 2;
-                key_to_send = 'a';
-                break;
-            case GPIO_BUTTON_S:
-                button_index = 3;
-                key_to_send = 's';
-                break;
-            default:
-                return; // Unknown GPIO
+    if (btstack_ring_buffer_write(&send_buffer, (uint8_t *) &character, 1) != ERROR_CODE_SUCCESS){
+        send_buffer_overflows++;
+        printf("Send buffer full, %u characters dropped\n", send_buffer_overflows);
+    }
+    typing_start();
+}
+
+uint32_t type_string(const char * text, uint32_t len){
+    uint32_t bytes_taken = send_buffer_fill(text, len);
+    typing_start();
+    return bytes_taken;
+}
+
+#ifdef ENABLE_STDIN_STREAM
+static void stdin_stream_process(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(ds);
+    UNUSED(callback_type);
+    stdin_stream_fill();
+    typing_start();
+}
+#endif
+
+#if defined(ENABLE_STATS_DUMP) && !defined(ENABLE_STDIN_STREAM)
+// stdin only carries commands
+static void stdin_command_process(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(ds);
+    UNUSED(callback_type);
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT){
+        if (c == CHAR_DUMP_STATS){
+            stats_dump();
         }
-        
-        // Debounce check
-        if (current_time - last_button_press_time[button_index] > DEBOUNCE_MS) {
-            last_button_press_time[button_index] = current_time;
-            
-            if (app_state == APP_CONNECTED) {
-                // Send key press if connected
-                printf("Button press on GPIO %d - sending '%c'\n", gpio, key_to_send);
-                queue_character(key_to_send);
-            } else if (app_state == APP_NOT_CONNECTED && gpio == GPIO_BUTTON_D) {
-                // Use button D to initiate connection if not connected
-                printf("Button press on GPIO %d - connecting to %s\n", gpio, bd_addr_to_str(device_addr));
-                hid_device_connect(device_addr, &hid_cid);
-                app_state = APP_CONNECTING;
-            }
+    }
+}
+#endif
+
+#if defined(ENABLE_STDIN_STREAM) || defined(ENABLE_STATS_DUMP)
+// called from USB interrupt when new characters arrive
+static void stdin_chars_available(void * context){
+    UNUSED(context);
+    btstack_run_loop_poll_data_sources_from_irq();
+}
+#endif
+
+// debounced key press or release, on run loop
+static void key_event(const key_event_t * event){
+    uint8_t keycode = event->keycode;
+    bool pressed = event->pressed;
+#ifdef ENABLE_MULTI_HOST
+    // chord keys are not part of any report
+    if (host_switch_chord(keycode, pressed)) return;
+#endif
+#ifdef ENABLE_CORE1_INPUT
+    // track held keys also while not connected, as core1 does
+    memcpy(input_report_payload, event->payload, REPORT_PAYLOAD_SIZE);
+#endif
+    if (app_state == APP_CONNECTED) {
+#ifdef ENABLE_COMPOSITE
+        if (keycode >= INPUT_COMPOSITE_FIRST){
+            composite_input(keycode, pressed);
+            return;
+        }
+#endif
+#ifdef ENABLE_LATENCY_STATS
+        key_latency_key_event(&key_latency, event->timestamp_us, time_us_32());
+#endif
+        // Key is held in the report exactly as long as the button, buttons held together go out in one report
+#ifdef ENABLE_KEY_EVENT_LOG
+        printf("Key 0x%02x %s\n", keycode, pressed ? "down" : "up");
+#endif
+#ifndef ENABLE_CORE1_INPUT
+        if (pressed){
+            key_state_press(&key_state, keycode);
+        } else {
+            key_state_release(&key_state, keycode);
+        }
+#endif
+        request_report();
+    } else if (pressed && app_state == APP_NOT_CONNECTED && keycode == CONNECT_KEYCODE) {
+        // Use button D to initiate connection if not connected
+        printf("Key 0x%02x down - connecting to %s\n", keycode, bd_addr_to_str(device_addr));
+        hid_device_connect(device_addr, &hid_cid);
+        app_state = APP_CONNECTING;
+    }
+}
+
+static void key_event_process(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(ds);
+    UNUSED(callback_type);
+    key_event_t event;
+    while (key_input_queue_get(&key_event_queue, &event)){
+        key_event(&event);
+    }
+    key_input_queue_report_overflows(&key_event_queue);
+}
+
+// queue key event in interrupt context or on core1
+static void key_event_post(uint8_t keycode, bool pressed){
+    key_event_t event;
+    event.keycode = keycode;
+    event.pressed = pressed;
+#ifdef ENABLE_LATENCY_STATS
+    event.timestamp_us = time_us_32();
+#endif
+#ifdef ENABLE_CORE1_INPUT
+    if (pressed){
+        key_state_press(&key_state, keycode);
+    } else {
+        key_state_release(&key_state, keycode);
+    }
+    report_payload_compose(event.payload);
+#endif
+    key_input_queue_post(&key_event_queue, &event);
+}
+
+#ifdef ENABLE_KEY_MATRIX
+
+static void key_matrix_callback(uint8_t row, uint8_t col, bool pressed, void * context){
+    bool * posted = (bool *) context;
+    uint8_t keycode = key_matrix_keymap[row][col];
+    if (keycode == 0) return;
+    key_event_post(keycode, pressed);
+    *posted = true;
+}
+
+// debounce and diff the latest matrix snapshot, returns true if key events were posted
+static bool input_sample(void){
+    uint32_t snapshot[MATRIX_ROWS];
+    key_matrix_pio_get_snapshot(snapshot);
+    bool posted = false;
+    key_matrix_update(&key_matrix, snapshot, &key_matrix_callback, &posted);
+    return posted;
+}
+
+#else
+
+// sample all buttons at once and debounce them, returns true if key events were posted
+static bool input_sample(void){
+    return key_input_buttons_sample(&key_input_buttons, &key_event_post);
+}
+
+#endif
+
+#ifdef ENABLE_CORE1_INPUT
+
+// core1: sample every DEBOUNCE_SAMPLE_US, unaffected by radio and Bluetooth processing on core0
+static void input_core1_entry(void){
+    // flash writes on core0 (e.g. TLV) pause core1
+    multicore_lockout_victim_init();
+    absolute_time_t next_sample = get_absolute_time();
+    while (true){
+        next_sample = delayed_by_us(next_sample, DEBOUNCE_SAMPLE_US);
+        busy_wait_until(next_sample);
+        if (input_sample()){
+            // wake up run loop on core0
+            btstack_run_loop_poll_data_sources_from_irq();
         }
     }
 }
 
+#else
+
+static repeating_timer_t input_sample_timer;
+
+// Periodic timer in interrupt context
+static bool input_sample_callback(repeating_timer_t * rt){
+    UNUSED(rt);
+    if (input_sample()){
+        // wake up run loop
+        btstack_run_loop_poll_data_sources_from_irq();
+    }
+    return true;
+}
+
+#endif
+
+// Sample input from a hardware timer (or core1) instead of using edge interrupts
+static void init_input_sampling(void) {
+#ifdef ENABLE_CORE1_INPUT
+    multicore_launch_core1(&input_core1_entry);
+    printf("Input sampled on core1\n");
+#else
+    add_repeating_timer_us(-DEBOUNCE_SAMPLE_US, &input_sample_callback, NULL, &input_sample_timer);
+#endif
+}
+
+// print boot trace once, on the first connection or at BOOT_TRACE_TIMEOUT_MS.
+// Output over USB is held back by boot_trace_defer_output() until the CDC port is opened.
+static void boot_trace_done(void){
+    if (boot_trace_printed) return;
+    boot_trace_printed = true;
+    btstack_run_loop_remove_timer(&boot_trace_timer);
+    boot_trace_print();
+}
+
+static void boot_trace_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    boot_trace_done();
+}
+
 // Initialize GPIO for status LED
 static void init_status_led(void) {
     gpio_init(GPIO_STATUS_LED);
@@ -351,49 +1372,79 @@ static void init_status_led(void) {
     printf("Status LED initialized on GPIO %d\n", GPIO_STATUS_LED);
 }
 
+// Key events are handed over to the run loop via key_event_queue
+static void init_key_events(void) {
+    key_input_queue_init(&key_event_queue, key_event_storage, sizeof(key_event_t), KEY_EVENT_QUEUE_SIZE, &key_event_process);
+}
+
+#ifdef ENABLE_KEY_MATRIX
+
+// Initialize key matrix scanner
+static void init_key_matrix(void) {
+    // PIO and DMA scan the matrix continuously, the timer only processes the latest snapshot
+    key_matrix_pio_init(MATRIX_ROW_BASE, MATRIX_ROWS, MATRIX_COL_BASE, MATRIX_COLS, MATRIX_SCAN_RATE_HZ);
+    key_matrix_init(&key_matrix, MATRIX_ROWS, MATRIX_COLS, DEBOUNCE_SAMPLES);
+
+    printf("Key matrix initialized (%d rows from GPIO %d, %d columns from GPIO %d)\n",
+           MATRIX_ROWS, MATRIX_ROW_BASE, MATRIX_COLS, MATRIX_COL_BASE);
+}
+
+#else
+
 // Initialize GPIO for buttons
 static void init_gpio_buttons(void) {
-    // Initialize all buttons with pull-ups
-    gpio_init(GPIO_BUTTON_D);
-    gpio_set_dir(GPIO_BUTTON_D, GPIO_IN);
-    gpio_pull_up(GPIO_BUTTON_D);
-    
-    gpio_init(GPIO_BUTTON_W);
-    gpio_set_dir(GPIO_BUTTON_W, GPIO_IN);
-    gpio_pull_up(GPIO_BUTTON_W);
-    
-    gpio_init(GPIO_BUTTON_A);
-    gpio_set_dir(GPIO_BUTTON_A, GPIO_IN);
-    gpio_pull_up(GPIO_BUTTON_A);
-    
-    gpio_init(GPIO_BUTTON_S);
-    gpio_set_dir(GPIO_BUTTON_S, GPIO_IN);
-    gpio_pull_up(GPIO_BUTTON_S);
-    
-    // Set up GPIO interrupts for all buttons (falling edge)
-    gpio_set_irq_enabled_with_callback(GPIO_BUTTON_D, GPIO_IRQ_EDGE_FALL, true, &gpio_callback);
-    gpio_set_irq_enabled(GPIO_BUTTON_W, GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(GPIO_BUTTON_A, GPIO_IRQ_EDGE_FALL, true);
-    gpio_set_irq_enabled(GPIO_BUTTON_S, GPIO_IRQ_EDGE_FALL, true);
-    
+    key_input_buttons_init(&key_input_buttons, buttons, NUM_BUTTONS, DEBOUNCE_SAMPLES);
+
     printf("GPIO buttons initialized (D=%d, W=%d, A=%d, S=%d)\n", 
            GPIO_BUTTON_D, GPIO_BUTTON_W, GPIO_BUTTON_A, GPIO_BUTTON_S);
 }
 
+#endif
+
 static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t packet_size){
     UNUSED(channel);
     UNUSED(packet_size);
     uint8_t status;
+#if defined(ENABLE_AUTO_RECONNECT) || defined(ENABLE_MULTI_HOST)
+    bd_addr_t event_addr;
+#endif
     switch (packet_type){
         case HCI_EVENT_PACKET:
             switch (hci_event_packet_get_type(packet)){
                 case BTSTACK_EVENT_STATE:
                     if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) return;
+                    boot_trace_mark("HCI working");
                     app_state = APP_NOT_CONNECTED;
                     update_status_led();  // Update LED status
+#ifdef ENABLE_MULTI_HOST
+                    host_slots_load();
+#endif
+#ifdef ENABLE_AUTO_RECONNECT
+                    printf("BTstack ready.\n");
+                    reconnect_start();
+#else
                     printf("BTstack ready. Press button D to connect or pair.\n");
+#endif
                     break;
 
+#if defined(ENABLE_ADAPTIVE_PACING) || defined(ENABLE_SNIFF_MANAGER)
+                case HCI_EVENT_MODE_CHANGE:
+                    if (hci_event_mode_change_get_handle(packet) != hid_con_handle) break;
+                    if (hci_event_mode_change_get_status(packet) != ERROR_CODE_SUCCESS) break;
+#ifdef ENABLE_ADAPTIVE_PACING
+                    // sniff interval is in 0.625 ms slots
+                    if (hci_event_mode_change_get_mode(packet) == 0x02){   // Sniff Mode
+                        pacing_sniff_interval_ms = hci_event_mode_change_get_interval(packet) * 625 / 1000;
+                    } else {
+                        pacing_sniff_interval_ms = 0;
+                    }
+#endif
+#ifdef ENABLE_SNIFF_MANAGER
+                    sniff_manager_mode_change(hci_event_mode_change_get_mode(packet), hci_event_mode_change_get_interval(packet));
+#endif
+                    break;
+#endif
+
                 case HCI_EVENT_USER_CONFIRMATION_REQUEST:
                     // ssp: inform about user confirmation request
                     log_info("SSP User Confirmation Request with numeric value '%06"PRIu32"'\n", hci_event_user_confirmation_request_get_numeric_value(packet));
@@ -410,35 +1461,80 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * pack
                                 app_state = APP_NOT_CONNECTED;
                                 hid_cid = 0;
                                 update_status_led();  // Update LED status
+#ifdef ENABLE_AUTO_RECONNECT
+                                reconnect_failed();
+#endif
                                 return;
                             }
                             app_state = APP_CONNECTED;
+                            if (boot_trace_printed == false){
+                                boot_trace_mark("HID connected");
+                                boot_trace_done();
+                            }
                             hid_cid = hid_subevent_connection_opened_get_hid_cid(packet);
+                            hid_con_handle = hid_subevent_connection_opened_get_con_handle(packet);
                             update_status_led();  // Update LED status
+#if defined(ENABLE_AUTO_RECONNECT) || defined(ENABLE_MULTI_HOST)
+                            hid_subevent_connection_opened_get_bd_addr(packet, event_addr);
+#endif
+#ifdef ENABLE_AUTO_RECONNECT
+                            reconnect_connected(event_addr);
+#endif
+#ifdef ENABLE_MULTI_HOST
+                            host_slots_connected(event_addr);
+#endif
                             printf("HID Connected! Press WASD buttons to send keystrokes.\n");
+#ifdef ENABLE_TYPING_BENCHMARK
+                            typing_benchmark_pos = 0;
+#endif
+#ifdef ENABLE_SNIFF_MANAGER
+                            // start idle timer
+                            sniff_manager_activity();
+#endif
+#ifdef TYPE_ON_CONNECT
+                            type_string(TYPE_ON_CONNECT, sizeof(TYPE_ON_CONNECT) - 1);
+#endif
+                            // type text queued while not connected
+                            typing_start();
                             break;
                         case HID_SUBEVENT_CONNECTION_CLOSED:
                             btstack_run_loop_remove_timer(&send_timer);
+#ifndef ENABLE_CORE1_INPUT
+                            // with core1 input, held keys stay tracked and are reported after reconnect
+                            key_state_clear(&key_state);
+#endif
+                            send_keycode = 0;
+                            send_modifier = 0;
+                            send_typing_report = false;
+                            send_report_pending = false;
+                            send_lookahead = false;
+                            send_active = false;
+                            hid_con_handle = HCI_CON_HANDLE_INVALID;
+#ifdef ENABLE_ADAPTIVE_PACING
+                            pacing_sniff_interval_ms = 0;
+#endif
+#ifdef ENABLE_SNIFF_MANAGER
+                            sniff_manager_reset();
+#endif
+#ifdef ENABLE_COMPOSITE
+                            composite_reset();
+#endif
+#ifdef ENABLE_ACL_TELEMETRY
+                            acl_telemetry_connection_closed(&acl_telemetry);
+                            acl_telemetry_dump(&acl_telemetry);
+#endif
                             printf("HID Disconnected\n");
                             app_state = APP_NOT_CONNECTED;
                             hid_cid = 0;
                             update_status_led();  // Update LED status
+#ifdef ENABLE_MULTI_HOST
+                            if (host_switch_pending){
+                                host_switch_connect();
+                            }
+#endif
                             break;
                         case HID_SUBEVENT_CAN_SEND_NOW:
-                            if (send_keycode){
-                                send_report(send_modifier, send_keycode);
-                                // schedule key up
-                                send_keycode = 0;
-                                send_modifier = 0;
-                                btstack_run_loop_set_timer_handler(&send_timer, trigger_key_up);
-                                btstack_run_loop_set_timer(&send_timer, TYPING_KEYDOWN_MS);
-                            } else {
-                                send_report(0, 0);
-                                // schedule next key down
-                                btstack_run_loop_set_timer_handler(&send_timer, send_next);
-                                btstack_run_loop_set_timer(&send_timer, TYPING_DELAY_MS);
-                            }
-                            btstack_run_loop_add_timer(&send_timer);
+                            hid_keyboard_can_send_now();
                             break;
                         default:
                             break;
@@ -464,33 +1560,49 @@ int btstack_main(int argc, const char * argv[]){
     (void)argc;
     (void)argv;
 
+    boot_trace_mark("btstack_main");
+
+#ifndef ENABLE_FAST_BOOT
     // Initialize Pico stdio
     stdio_init_all();
     
     // Allow time for USB to initialize
     sleep_ms(2000);
+#endif
     
     printf("\n\nHID Keyboard Demo with GPIO Buttons Starting...\n");
     
     // Initialize status LED
     init_status_led();
     
-    // Initialize GPIO buttons
+    // Initialize input
+    init_key_events();
+#ifdef ENABLE_KEY_MATRIX
+    init_key_matrix();
+#else
     init_gpio_buttons();
+#endif
+    init_input_sampling();
     
     // Parse the target Bluetooth address
     sscanf_bd_addr(device_addr_string, device_addr);
 
     // allow to get found by inquiry
     gap_discoverable_control(1);
-    // use Limited Discoverable Mode; Peripheral; Keyboard as CoD
-    gap_set_class_of_device(0x2540);
+    // use Limited Discoverable Mode; Peripheral; Keyboard (or Combo Keyboard / Pointing) as CoD
+    gap_set_class_of_device(HID_DEVICE_SUBCLASS);
     // set local name to be identified - zeroes will be replaced by actual BD ADDR
     gap_set_local_name("HID Keyboard Demo 00:00:00:00:00:00");
     // allow for role switch in general and sniff mode
     gap_set_default_link_policy_settings( LM_LINK_POLICY_ENABLE_ROLE_SWITCH | LM_LINK_POLICY_ENABLE_SNIFF_MODE );
     // allow for role switch on outgoing connections - this allow HID Host to become master when we re-connect to it
     gap_set_allow_role_switch(true);
+#ifdef ENABLE_AUTO_RECONNECT
+    // give up on an absent host early and retry later, be quick to answer a host that reconnects
+    gap_set_page_timeout(RECONNECT_PAGE_TIMEOUT);
+    gap_set_page_scan_activity(PAGE_SCAN_INTERVAL, PAGE_SCAN_WINDOW);
+    gap_set_page_scan_type(PAGE_SCAN_MODE_INTERLACED);
+#endif
 
     // L2CAP
     l2cap_init();
@@ -510,8 +1622,8 @@ int btstack_main(int argc, const char * argv[]){
     uint8_t hid_normally_connectable = 1;
 
     hid_sdp_record_t hid_params = {
-        // hid sevice subclass 2540 Keyboard, hid counntry code 33 US
-        0x2540, 33, 
+        // hid sevice subclass 2540 Keyboard (25c0 Combo), hid counntry code 33 US
+        HID_DEVICE_SUBCLASS, 33, 
         hid_virtual_cable, hid_remote_wake, 
         hid_reconnect_initiate, hid_normally_connectable,
         hid_boot_device,
@@ -531,6 +1643,7 @@ int btstack_main(int argc, const char * argv[]){
     device_id_create_sdp_record(device_id_sdp_service_buffer, sdp_create_service_record_handle(), DEVICE_ID_VENDOR_ID_SOURCE_BLUETOOTH, BLUETOOTH_COMPANY_ID_BLUEKITCHEN_GMBH, 1, 1);
     btstack_assert(de_get_len( device_id_sdp_service_buffer) <= sizeof(device_id_sdp_service_buffer));
     sdp_register_service(device_id_sdp_service_buffer);
+    boot_trace_mark("SDP registered");
 
     // HID Device
     hid_device_init(hid_boot_device, sizeof(hid_descriptor_keyboard), hid_descriptor_keyboard);
@@ -544,7 +1657,27 @@ int btstack_main(int argc, const char * argv[]){
 
     btstack_ring_buffer_init(&send_buffer, send_buffer_storage, sizeof(send_buffer_storage));
 
+#ifdef ENABLE_STDIN_STREAM
+    btstack_run_loop_set_data_source_handler(&stdin_stream_data_source, &stdin_stream_process);
+    btstack_run_loop_enable_data_source_callbacks(&stdin_stream_data_source, DATA_SOURCE_CALLBACK_POLL);
+    btstack_run_loop_add_data_source(&stdin_stream_data_source);
+#endif
+#if defined(ENABLE_STATS_DUMP) && !defined(ENABLE_STDIN_STREAM)
+    btstack_run_loop_set_data_source_handler(&stdin_command_data_source, &stdin_command_process);
+    btstack_run_loop_enable_data_source_callbacks(&stdin_command_data_source, DATA_SOURCE_CALLBACK_POLL);
+    btstack_run_loop_add_data_source(&stdin_command_data_source);
+#endif
+#if defined(ENABLE_STDIN_STREAM) || defined(ENABLE_STATS_DUMP)
+    stdio_set_chars_available_callback(&stdin_chars_available, NULL);
+#endif
+
+    uint32_t boot_ms = to_ms_since_boot(get_absolute_time());
+    btstack_run_loop_set_timer_handler(&boot_trace_timer, &boot_trace_handler);
+    btstack_run_loop_set_timer(&boot_trace_timer, (boot_ms < BOOT_TRACE_TIMEOUT_MS) ? (BOOT_TRACE_TIMEOUT_MS - boot_ms) : 0);
+    btstack_run_loop_add_timer(&boot_trace_timer);
+
     // turn on!
+    boot_trace_mark("HCI power on");
     hci_power_control(HCI_POWER_ON);
     
     printf("Bluetooth stack initialized. Press button D to connect.\n");
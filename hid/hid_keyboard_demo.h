@@ -0,0 +1,28 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HID_KEYBOARD_DEMO_H
+#define HID_KEYBOARD_DEMO_H
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Queue text for typing. Text that doesn't fit into the send buffer is not taken,
+ * the caller offers the remainder again later, e.g. after typing progressed.
+ * Characters without a key in the US layout are skipped. Call from the run loop only.
+ * @param text
+ * @param len
+ * @return number of bytes taken
+ */
+uint32_t type_string(const char * text, uint32_t len);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // HID_KEYBOARD_DEMO_H
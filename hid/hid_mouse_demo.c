@@ -59,71 +59,215 @@
 #include "btstack_stdin.h"
 #endif
 
+#include "acl_telemetry.h"
+
 // to enable demo text on POSIX systems
 // #undef HAVE_BTSTACK_STDIN
 
-static uint8_t hid_service_buffer[270];
+// Pace simulated mouse reports by CAN_SEND_NOW arrival and sniff interval instead of MOUSE_PERIOD_MS
+// #define ENABLE_ADAPTIVE_PACING
+
+// Count ACL buffer usage, CAN_SEND_NOW waits and coalesced reports, printed on disconnect ('t' on stdin)
+// #define ENABLE_ACL_TELEMETRY
+
+// Report X/Y as 16-bit instead of 8-bit values, fast movement then needs fewer reports
+// #define ENABLE_MOUSE_16BIT
+
+// Motion and button changes are merged into the next report, reports are only requested while
+// something changed and not more often than MOUSE_MAX_REPORT_RATE_HZ
+#define MOUSE_MAX_REPORT_RATE_HZ        125
+#define MOUSE_MIN_REPORT_INTERVAL_MS    (1000 / MOUSE_MAX_REPORT_RATE_HZ)
+
+// Print reports/s, merged inputs and estimated airtime every REPORT_STATS_PERIOD_MS while connected
+// #define ENABLE_REPORT_STATS
+#define REPORT_STATS_PERIOD_MS          5000
+
+// report descriptors, shared with the HID-over-GATT mouse
+#include "hid_descriptor_mouse.h"
+
+#ifdef ENABLE_MOUSE_16BIT
+#define hid_descriptor_mouse hid_descriptor_mouse_16bit
+#define MOUSE_DELTA_MAX      32767
+#else
+#define hid_descriptor_mouse hid_descriptor_mouse_boot_mode
+#define MOUSE_DELTA_MAX      127
+#endif
+
+static uint8_t hid_service_buffer[220 + sizeof(hid_descriptor_mouse)];
 static uint8_t device_id_sdp_service_buffer[100];
 static const char hid_device_name[] = "BTstack HID Mouse";
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 static uint16_t hid_cid;
+static hci_con_handle_t hid_con_handle = HCI_CON_HANDLE_INVALID;
 
-// from USB HID Specification 1.1, Appendix B.2
-const uint8_t hid_descriptor_mouse_boot_mode[] = {
-    0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
-    0x09, 0x02,                    // USAGE (Mouse)
-    0xa1, 0x01,                    // COLLECTION (Application)
-
-    0x09, 0x01,                    //   USAGE (Pointer)
-    0xa1, 0x00,                    //   COLLECTION (Physical)
-
-    0x05, 0x09,                    //     USAGE_PAGE (Button)
-    0x19, 0x01,                    //     USAGE_MINIMUM (Button 1)
-    0x29, 0x03,                    //     USAGE_MAXIMUM (Button 3)
-    0x15, 0x00,                    //     LOGICAL_MINIMUM (0)
-    0x25, 0x01,                    //     LOGICAL_MAXIMUM (1)
-    0x95, 0x03,                    //     REPORT_COUNT (3)
-    0x75, 0x01,                    //     REPORT_SIZE (1)
-    0x81, 0x02,                    //     INPUT (Data,Var,Abs)
-    0x95, 0x01,                    //     REPORT_COUNT (1)
-    0x75, 0x05,                    //     REPORT_SIZE (5)
-    0x81, 0x03,                    //     INPUT (Cnst,Var,Abs)
-
-    0x05, 0x01,                    //     USAGE_PAGE (Generic Desktop)
-    0x09, 0x30,                    //     USAGE (X)
-    0x09, 0x31,                    //     USAGE (Y)
-    0x15, 0x81,                    //     LOGICAL_MINIMUM (-127)
-    0x25, 0x7f,                    //     LOGICAL_MAXIMUM (127)
-    0x75, 0x08,                    //     REPORT_SIZE (8)
-    0x95, 0x02,                    //     REPORT_COUNT (2)
-    0x81, 0x06,                    //     INPUT (Data,Var,Rel)
-
-    0xc0,                          //   END_COLLECTION
-    0xc0                           // END_COLLECTION
-};
+#ifdef ENABLE_ADAPTIVE_PACING
+// sniff interval of the HID connection, 0 in active mode
+static uint32_t pacing_sniff_interval_ms;
+#endif
+
+#ifdef ENABLE_ACL_TELEMETRY
+static acl_telemetry_t acl_telemetry;
+#endif
+
+#ifdef ENABLE_REPORT_STATS
+// Estimated airtime of one report: a basic rate DH1 packet with 72 bit access code, 54 bit header,
+// payload header, L2CAP header, HID message and CRC, at 1 us per bit. Polls and acks are not counted
+#define REPORT_AIRTIME_US(message_len) (72 + 54 + 8 * (1 + 4 + (message_len) + 2))
+
+static btstack_timer_source_t report_stats_timer;
+static uint32_t               report_stats_start_ms;
+static uint32_t               report_stats_reports;
+static uint32_t               report_stats_inputs;      // motion or button changes
+static uint32_t               report_stats_airtime_us;
+#endif
 
 // HID Report sending
-static void send_report(uint8_t buttons, int8_t dx, int8_t dy){
-    // setup HID message: A1 = Input Report, Report ID, Payload
+static void send_report(uint8_t buttons, int16_t dx, int16_t dy){
+    // setup HID message: A1 = Input Report, Payload
+#ifdef ENABLE_MOUSE_16BIT
+    uint8_t message[] = {0xa1, buttons, (uint8_t) dx, (uint8_t) (dx >> 8), (uint8_t) dy, (uint8_t) (dy >> 8)};
+#else
     uint8_t message[] = {0xa1, buttons, (uint8_t) dx, (uint8_t) dy};
+#endif
     hid_device_send_interrupt_message(hid_cid, &message[0], sizeof(message));
+#ifdef ENABLE_ACL_TELEMETRY
+    acl_telemetry_report_sent(&acl_telemetry, hid_con_handle);
+#endif
+#ifdef ENABLE_REPORT_STATS
+    report_stats_reports++;
+    report_stats_airtime_us += REPORT_AIRTIME_US(sizeof(message));
+#endif
     printf("Mouse: %d/%d - buttons: %02x\n", dx, dy, buttons);
 }
 
+#ifdef ENABLE_REPORT_STATS
+static void report_stats_handler(btstack_timer_source_t * ts){
+    uint32_t now_ms = btstack_run_loop_get_time_ms();
+    uint32_t elapsed_ms = now_ms - report_stats_start_ms;
+    if (elapsed_ms > 0){
+        uint32_t airtime_us_per_s = (uint32_t) (((uint64_t) report_stats_airtime_us * 1000) / elapsed_ms);
+        printf("Reports: %u/s, %u inputs merged into %u reports, airtime %u us/s (%u.%u %%)\n",
+               report_stats_reports * 1000 / elapsed_ms, report_stats_inputs, report_stats_reports,
+               airtime_us_per_s, airtime_us_per_s / 10000, (airtime_us_per_s / 1000) % 10);
+    }
+    report_stats_start_ms = now_ms;
+    report_stats_reports = 0;
+    report_stats_inputs = 0;
+    report_stats_airtime_us = 0;
+    btstack_run_loop_set_timer(ts, REPORT_STATS_PERIOD_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+static void report_stats_start(void){
+    report_stats_start_ms = btstack_run_loop_get_time_ms();
+    report_stats_reports = 0;
+    report_stats_inputs = 0;
+    report_stats_airtime_us = 0;
+    btstack_run_loop_set_timer_handler(&report_stats_timer, &report_stats_handler);
+    btstack_run_loop_set_timer(&report_stats_timer, REPORT_STATS_PERIOD_MS);
+    btstack_run_loop_add_timer(&report_stats_timer);
+}
+#endif
+
+// movement not reported yet
 static int dx;
 static int dy;
 static uint8_t buttons;
+static uint8_t buttons_reported;    // buttons in the last report
 static int hid_boot_device = 0;
+static bool report_pending;
+
+// rate limit: time of last report, timer until the next one may be requested
+static uint32_t               report_last_ms;
+static bool                   report_sent;
+static btstack_timer_source_t report_rate_timer;
+static bool                   report_rate_timer_active;
+
+// motion or button change not reported yet
+static bool mousing_dirty(void){
+    return (dx != 0) || (dy != 0) || (buttons != buttons_reported);
+}
+
+static void mousing_request_report(void);
+
+static void report_rate_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    report_rate_timer_active = false;
+    if (mousing_dirty()){
+        mousing_request_report();
+    }
+}
+
+// request CAN_SEND_NOW, changes until then go into the same report.
+// Within MOUSE_MIN_REPORT_INTERVAL_MS after the last report, the request is deferred instead
+static void mousing_request_report(void){
+    if (report_pending || report_rate_timer_active){
+#ifdef ENABLE_ACL_TELEMETRY
+        acl_telemetry_report_coalesced(&acl_telemetry);
+#endif
+        return;
+    }
+    uint32_t elapsed_ms = btstack_run_loop_get_time_ms() - report_last_ms;
+    if (report_sent && (elapsed_ms < MOUSE_MIN_REPORT_INTERVAL_MS)){
+        report_rate_timer_active = true;
+        btstack_run_loop_set_timer_handler(&report_rate_timer, &report_rate_handler);
+        btstack_run_loop_set_timer(&report_rate_timer, MOUSE_MIN_REPORT_INTERVAL_MS - elapsed_ms);
+        btstack_run_loop_add_timer(&report_rate_timer);
+        return;
+    }
+    report_pending = true;
+    hid_device_request_can_send_now_event(hid_cid);
+#ifdef ENABLE_ACL_TELEMETRY
+    acl_telemetry_can_send_now_requested(&acl_telemetry, hid_con_handle);
+#endif
+}
+
+#if defined(ENABLE_ADAPTIVE_PACING) && !defined(HAVE_BTSTACK_STDIN)
+static void mousing_schedule_next(void);
+#endif
+
+// take as much of the accumulated movement as fits into one report, the remainder stays for the next one
+static int16_t mousing_take_delta(int * accumulator){
+    int delta = *accumulator;
+    if (delta >  MOUSE_DELTA_MAX) delta =  MOUSE_DELTA_MAX;
+    if (delta < -MOUSE_DELTA_MAX) delta = -MOUSE_DELTA_MAX;
+    *accumulator -= delta;
+    return (int16_t) delta;
+}
+
+// motion and button presses from input, buttons are released again after being reported (click)
+static void mousing_input(int delta_x, int delta_y, uint8_t pressed_buttons){
+    dx += delta_x;
+    dy += delta_y;
+    buttons |= pressed_buttons;
+#ifdef ENABLE_REPORT_STATS
+    report_stats_inputs++;
+#endif
+    if (mousing_dirty() == false) return;
+    mousing_request_report();
+}
 
 static void mousing_can_send_now(void){
-    send_report(buttons, dx, dy);
-    // reset
-    dx = 0;
-    dy = 0;
-    if (buttons){
-        buttons = 0;
-        hid_device_request_can_send_now_event(hid_cid);
+    report_pending = false;
+#ifdef ENABLE_ACL_TELEMETRY
+    acl_telemetry_can_send_now(&acl_telemetry);
+#endif
+    int16_t report_dx = mousing_take_delta(&dx);
+    int16_t report_dy = mousing_take_delta(&dy);
+    send_report(buttons, report_dx, report_dy);
+    report_sent = true;
+    report_last_ms = btstack_run_loop_get_time_ms();
+    buttons_reported = buttons;
+    // click is released in the next report, which also carries remaining movement
+    buttons = 0;
+    if (mousing_dirty()){
+        mousing_request_report();
+        return;
     }
+#if defined(ENABLE_ADAPTIVE_PACING) && !defined(HAVE_BTSTACK_STDIN)
+    // next step is timed from this report going out
+    mousing_schedule_next();
+#endif
 }
 
 // Demo Application
@@ -143,27 +287,31 @@ static void stdin_process(char character){
 
     switch (character){
         case 'a':
-            dx -= MOUSE_SPEED;
+            mousing_input(-MOUSE_SPEED, 0, 0);
             break;
         case 's':
-            dy += MOUSE_SPEED;
+            mousing_input(0, MOUSE_SPEED, 0);
             break;
         case 'd':
-            dx += MOUSE_SPEED;
+            mousing_input(MOUSE_SPEED, 0, 0);
             break;
         case 'w':
-            dy -= MOUSE_SPEED;
+            mousing_input(0, -MOUSE_SPEED, 0);
             break;
         case 'l':
-            buttons |= 1;
+            mousing_input(0, 0, 1);
             break;
         case 'r':
-            buttons |= 2;
+            mousing_input(0, 0, 2);
             break;
+#ifdef ENABLE_ACL_TELEMETRY
+        case 't':
+            acl_telemetry_dump(&acl_telemetry);
+            break;
+#endif
         default:
-            return;
+            break;
     }
-    hid_device_request_can_send_now_event(hid_cid);
 }
 
 #else
@@ -172,6 +320,9 @@ static void stdin_process(char character){
 
 #define MOUSE_PERIOD_MS 15
 
+// adaptive pacing: minimal time between two simulated steps
+#define MOUSE_MIN_PERIOD_MS 5
+
 static int step;
 static const int STEPS_PER_DIRECTION = 50;
 static const int MOUSE_SPEED = 10;
@@ -192,14 +343,10 @@ static void mousing_timer_handler(btstack_timer_source_t * ts){
 
     if (!hid_cid) return;
 
-    // simulate left click when corner reached
-    if (step % STEPS_PER_DIRECTION == 0){
-        buttons |= 1;
-    }
-    // simulate move
+    // simulate move, and left click when corner reached
     int direction_index = step / STEPS_PER_DIRECTION;
-    dx += directions[direction_index].dx * MOUSE_SPEED;
-    dy += directions[direction_index].dy * MOUSE_SPEED;
+    mousing_input(directions[direction_index].dx * MOUSE_SPEED, directions[direction_index].dy * MOUSE_SPEED,
+                  (step % STEPS_PER_DIRECTION == 0) ? 1 : 0);
 
     // next
     step++;
@@ -207,14 +354,31 @@ static void mousing_timer_handler(btstack_timer_source_t * ts){
         step = 0;
     }
 
-    // trigger send
-    hid_device_request_can_send_now_event(hid_cid);
-
+#ifdef ENABLE_ADAPTIVE_PACING
+    // next timer is set when the report was sent
+    UNUSED(ts);
+#else
     // set next timer
     btstack_run_loop_set_timer(ts, MOUSE_PERIOD_MS);
     btstack_run_loop_add_timer(ts);
+#endif
 }
 
+#ifdef ENABLE_ADAPTIVE_PACING
+// Schedule the next step from CAN_SEND_NOW instead of a fixed period. While the link is busy,
+// CAN_SEND_NOW arrives later, so the simulation slows down instead of queueing reports.
+static void mousing_schedule_next(void){
+    uint32_t delay_ms = MOUSE_MIN_PERIOD_MS;
+    // in sniff mode, spread reports over the interval, see MAX_NR_CONTROLLER_ACL_BUFFERS
+    uint32_t sniff_share_ms = pacing_sniff_interval_ms / MAX_NR_CONTROLLER_ACL_BUFFERS;
+    if (sniff_share_ms > delay_ms){
+        delay_ms = sniff_share_ms;
+    }
+    btstack_run_loop_set_timer(&mousing_timer, delay_ms);
+    btstack_run_loop_add_timer(&mousing_timer);
+}
+#endif
+
 static void hid_embedded_start_mousing(void){
     printf("Start mousing..\n");
 
@@ -239,11 +403,28 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * pack
                     log_info("SSP User Confirmation Auto accept\n");
                     break;
 
+#ifdef ENABLE_ADAPTIVE_PACING
+                case HCI_EVENT_MODE_CHANGE:
+                    if (hci_event_mode_change_get_handle(packet) != hid_con_handle) break;
+                    if (hci_event_mode_change_get_status(packet) != ERROR_CODE_SUCCESS) break;
+                    // sniff interval is in 0.625 ms slots
+                    if (hci_event_mode_change_get_mode(packet) == 0x02){   // Sniff Mode
+                        pacing_sniff_interval_ms = hci_event_mode_change_get_interval(packet) * 625 / 1000;
+                    } else {
+                        pacing_sniff_interval_ms = 0;
+                    }
+                    break;
+#endif
+
                 case HCI_EVENT_HID_META:
                     switch (hci_event_hid_meta_get_subevent_code(packet)){
                         case HID_SUBEVENT_CONNECTION_OPENED:
                             if (hid_subevent_connection_opened_get_status(packet) != ERROR_CODE_SUCCESS) return;
                             hid_cid = hid_subevent_connection_opened_get_hid_cid(packet);
+                            hid_con_handle = hid_subevent_connection_opened_get_con_handle(packet);
+#ifdef ENABLE_REPORT_STATS
+                            report_stats_start();
+#endif
 #ifdef HAVE_BTSTACK_STDIN
                             printf("HID Connected, control mouse using 'a','s',''d', 'w' keys for movement and 'l' and 'r' for buttons...\n");
 #else
@@ -254,6 +435,25 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * pack
                         case HID_SUBEVENT_CONNECTION_CLOSED:
                             printf("HID Disconnected\n");
                             hid_cid = 0;
+                            hid_con_handle = HCI_CON_HANDLE_INVALID;
+                            report_pending = false;
+                            report_sent = false;
+                            report_rate_timer_active = false;
+                            btstack_run_loop_remove_timer(&report_rate_timer);
+                            dx = 0;
+                            dy = 0;
+                            buttons = 0;
+                            buttons_reported = 0;
+#ifdef ENABLE_REPORT_STATS
+                            btstack_run_loop_remove_timer(&report_stats_timer);
+#endif
+#ifdef ENABLE_ADAPTIVE_PACING
+                            pacing_sniff_interval_ms = 0;
+#endif
+#ifdef ENABLE_ACL_TELEMETRY
+                            acl_telemetry_connection_closed(&acl_telemetry);
+                            acl_telemetry_dump(&acl_telemetry);
+#endif
                             break;
                         case HID_SUBEVENT_CAN_SEND_NOW:
                             mousing_can_send_now();
@@ -319,8 +519,8 @@ int btstack_main(int argc, const char * argv[]){
         hid_reconnect_initiate, hid_normally_connectable,
         hid_boot_device, 
         0xFFFF, 0xFFFF, 3200,
-        hid_descriptor_mouse_boot_mode,
-        sizeof(hid_descriptor_mouse_boot_mode), 
+        hid_descriptor_mouse,
+        sizeof(hid_descriptor_mouse), 
         hid_device_name
     };
 
@@ -336,7 +536,7 @@ int btstack_main(int argc, const char * argv[]){
     sdp_register_service(device_id_sdp_service_buffer);
 
     // HID Device
-    hid_device_init(hid_boot_device, sizeof(hid_descriptor_mouse_boot_mode), hid_descriptor_mouse_boot_mode);
+    hid_device_init(hid_boot_device, sizeof(hid_descriptor_mouse), hid_descriptor_mouse);
     // register for HCI events
     hci_event_callback_registration.callback = &packet_handler;
     hci_add_event_handler(&hci_event_callback_registration);
@@ -0,0 +1,383 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "hid_report_plan.h"
+
+#include <string.h>
+
+// short item prefix: tag (4 bits), type (2 bits), size (2 bits)
+#define HID_ITEM_TYPE_MAIN      0
+#define HID_ITEM_TYPE_GLOBAL    1
+#define HID_ITEM_TYPE_LOCAL     2
+#define HID_ITEM_LONG_PREFIX    0xfe
+
+#define HID_MAIN_INPUT          0x8
+#define HID_MAIN_OUTPUT         0x9
+#define HID_MAIN_COLLECTION     0xa
+#define HID_MAIN_FEATURE        0xb
+#define HID_MAIN_END_COLLECTION 0xc
+
+#define HID_GLOBAL_USAGE_PAGE   0x0
+#define HID_GLOBAL_LOGICAL_MIN  0x1
+#define HID_GLOBAL_LOGICAL_MAX  0x2
+#define HID_GLOBAL_REPORT_SIZE  0x7
+#define HID_GLOBAL_REPORT_ID    0x8
+#define HID_GLOBAL_REPORT_COUNT 0x9
+#define HID_GLOBAL_PUSH         0xa
+#define HID_GLOBAL_POP          0xb
+
+#define HID_LOCAL_USAGE         0x0
+#define HID_LOCAL_USAGE_MIN     0x1
+#define HID_LOCAL_USAGE_MAX     0x2
+
+// main item flags
+#define HID_MAIN_FLAG_CONSTANT  0x01
+#define HID_MAIN_FLAG_VARIABLE  0x02
+
+#define HID_REPORT_PLAN_MAX_USAGES      16
+#define HID_REPORT_PLAN_MAX_PUSH_DEPTH  4
+
+typedef struct {
+    uint16_t usage_page;
+    int32_t  logical_min;
+    uint32_t logical_max;       // raw, interpreted as signed if logical_min < 0
+    uint8_t  logical_max_size;
+    uint8_t  report_size;
+    uint8_t  report_id;
+    uint16_t report_count;
+} hid_global_state_t;
+
+typedef struct {
+    hid_global_state_t global;
+    hid_global_state_t global_stack[HID_REPORT_PLAN_MAX_PUSH_DEPTH];
+    uint8_t  global_stack_depth;
+    // usages are extended (page << 16 | usage) if given with 4 bytes, page 0 means current usage page
+    uint32_t usages[HID_REPORT_PLAN_MAX_USAGES];
+    uint8_t  num_usages;
+    uint32_t usage_min;
+    uint32_t usage_max;
+    bool     usage_range;
+    // per report: input bits so far
+    uint16_t report_bits[HID_REPORT_PLAN_MAX_REPORTS];
+    uint8_t  field_report[HID_REPORT_PLAN_MAX_FIELDS];
+} hid_report_plan_compiler_t;
+
+static int32_t hid_report_plan_sign_extend(uint32_t value, uint8_t bits){
+    if (bits == 0 || bits >= 32) return (int32_t) value;
+    uint32_t sign = 1u << (bits - 1);
+    return (int32_t) ((value ^ sign) - sign);
+}
+
+static void hid_report_plan_locals_clear(hid_report_plan_compiler_t * compiler){
+    compiler->num_usages = 0;
+    compiler->usage_range = false;
+    compiler->usage_min = 0;
+    compiler->usage_max = 0;
+}
+
+// find or add report, returns index or -1 if table is full
+static int hid_report_plan_report_index(hid_report_plan_t * plan, uint8_t report_id){
+    int i;
+    for (i = 0; i < plan->num_reports; i++){
+        if (plan->reports[i].report_id == report_id) return i;
+    }
+    if (plan->num_reports == HID_REPORT_PLAN_MAX_REPORTS) return -1;
+    plan->reports[plan->num_reports].report_id = report_id;
+    return plan->num_reports++;
+}
+
+// usage of slot i of the current main item, extended
+static uint32_t hid_report_plan_usage(const hid_report_plan_compiler_t * compiler, uint16_t slot){
+    uint32_t usage;
+    if (compiler->usage_range){
+        usage = compiler->usage_min + slot;
+        if (usage > compiler->usage_max){
+            usage = compiler->usage_max;
+        }
+    } else if (compiler->num_usages > 0){
+        // surplus slots use the last usage
+        usage = compiler->usages[(slot < compiler->num_usages) ? slot : (compiler->num_usages - 1)];
+    } else {
+        return 0;
+    }
+    if ((usage >> 16) == 0){
+        usage |= (uint32_t) compiler->global.usage_page << 16;
+    }
+    return usage;
+}
+
+static bool hid_report_plan_add_field(hid_report_plan_t * plan, hid_report_plan_compiler_t * compiler, uint8_t report_index,
+                                      const hid_report_field_t * field){
+    // extend run of variable fields with consecutive usages
+    if (plan->num_fields > 0){
+        hid_report_field_t * last = &plan->fields[plan->num_fields - 1];
+        if ((compiler->field_report[plan->num_fields - 1] == report_index)
+            && ((last->flags & HID_REPORT_FIELD_ARRAY) == 0) && (field->flags == last->flags)
+            && (last->bit_size == field->bit_size) && (last->usage_page == field->usage_page)
+            && (last->logical_min == field->logical_min) && (last->logical_max == field->logical_max)
+            && ((uint32_t) last->bit_offset + (uint32_t) last->count * last->bit_size == field->bit_offset)
+            && ((uint32_t) last->usage + last->count == field->usage)){
+            last->count++;
+            return true;
+        }
+    }
+    if (plan->num_fields == HID_REPORT_PLAN_MAX_FIELDS) return false;
+    compiler->field_report[plan->num_fields] = report_index;
+    plan->fields[plan->num_fields++] = *field;
+    return true;
+}
+
+static bool hid_report_plan_add_input(hid_report_plan_t * plan, hid_report_plan_compiler_t * compiler, uint32_t flags){
+    const hid_global_state_t * global = &compiler->global;
+    if (global->report_size > 32) return false;
+    int report_index = hid_report_plan_report_index(plan, global->report_id);
+    if (report_index < 0) return false;
+    uint32_t bit_offset = compiler->report_bits[report_index];
+    uint32_t total_bits = (uint32_t) global->report_size * global->report_count;
+    if (bit_offset + total_bits > 0xffff) return false;
+    compiler->report_bits[report_index] = (uint16_t) (bit_offset + total_bits);
+
+    // padding
+    if ((flags & HID_MAIN_FLAG_CONSTANT) || (total_bits == 0)) return true;
+
+    hid_report_field_t field;
+    memset(&field, 0, sizeof(field));
+    field.bit_size    = global->report_size;
+    field.logical_min = global->logical_min;
+    if (global->logical_min < 0){
+        field.flags |= HID_REPORT_FIELD_SIGNED;
+        field.logical_max = hid_report_plan_sign_extend(global->logical_max, global->logical_max_size * 8);
+    } else {
+        field.logical_max = (int32_t) global->logical_max;
+    }
+
+    uint32_t usage;
+    if ((flags & HID_MAIN_FLAG_VARIABLE) == 0){
+        // array: all slots share one entry
+        usage = hid_report_plan_usage(compiler, 0);
+        field.flags     |= HID_REPORT_FIELD_ARRAY;
+        field.bit_offset = (uint16_t) bit_offset;
+        field.count      = global->report_count;
+        field.usage_page = (uint16_t) (usage >> 16);
+        field.usage      = (uint16_t) usage;
+        return hid_report_plan_add_field(plan, compiler, (uint8_t) report_index, &field);
+    }
+
+    uint16_t slot;
+    for (slot = 0; slot < global->report_count; slot++){
+        usage = hid_report_plan_usage(compiler, slot);
+        field.bit_offset = (uint16_t) (bit_offset + (uint32_t) slot * global->report_size);
+        field.count      = 1;
+        field.usage_page = (uint16_t) (usage >> 16);
+        field.usage      = (uint16_t) usage;
+        if (hid_report_plan_add_field(plan, compiler, (uint8_t) report_index, &field) == false) return false;
+    }
+    return true;
+}
+
+// group fields by report, keeping descriptor order within a report
+static void hid_report_plan_group_fields(hid_report_plan_t * plan, hid_report_plan_compiler_t * compiler){
+    int i;
+    for (i = 1; i < plan->num_fields; i++){
+        hid_report_field_t field = plan->fields[i];
+        uint8_t report_index = compiler->field_report[i];
+        int j = i;
+        while ((j > 0) && (compiler->field_report[j - 1] > report_index)){
+            plan->fields[j] = plan->fields[j - 1];
+            compiler->field_report[j] = compiler->field_report[j - 1];
+            j--;
+        }
+        plan->fields[j] = field;
+        compiler->field_report[j] = report_index;
+    }
+    for (i = 0; i < plan->num_fields; i++){
+        hid_report_plan_report_t * report = &plan->reports[compiler->field_report[i]];
+        if (report->num_fields == 0){
+            report->first_field = (uint8_t) i;
+        }
+        report->num_fields++;
+    }
+}
+
+bool hid_report_plan_compile(hid_report_plan_t * plan, const uint8_t * descriptor, uint16_t descriptor_len){
+    hid_report_plan_compiler_t compiler;
+    memset(plan, 0, sizeof(hid_report_plan_t));
+    memset(&compiler, 0, sizeof(compiler));
+
+    uint16_t pos = 0;
+    while (pos < descriptor_len){
+        uint8_t prefix = descriptor[pos++];
+        if (prefix == HID_ITEM_LONG_PREFIX){
+            // long items are not used by any known device, skip them
+            if (pos >= descriptor_len) return false;
+            pos += 2 + descriptor[pos];
+            continue;
+        }
+        uint8_t size = prefix & 0x03;
+        if (size == 3){
+            size = 4;
+        }
+        if ((uint32_t) pos + size > descriptor_len) return false;
+        uint32_t data = 0;
+        uint8_t i;
+        for (i = 0; i < size; i++){
+            data |= (uint32_t) descriptor[pos + i] << (8 * i);
+        }
+        pos += size;
+        uint8_t type = (prefix >> 2) & 0x03;
+        uint8_t tag  = prefix >> 4;
+
+        switch (type){
+            case HID_ITEM_TYPE_MAIN:
+                if (tag == HID_MAIN_INPUT){
+                    if (hid_report_plan_add_input(plan, &compiler, data) == false) return false;
+                }
+                // output and feature reports are not part of the plan
+                hid_report_plan_locals_clear(&compiler);
+                break;
+            case HID_ITEM_TYPE_GLOBAL:
+                switch (tag){
+                    case HID_GLOBAL_USAGE_PAGE:
+                        compiler.global.usage_page = (uint16_t) data;
+                        break;
+                    case HID_GLOBAL_LOGICAL_MIN:
+                        compiler.global.logical_min = hid_report_plan_sign_extend(data, size * 8);
+                        break;
+                    case HID_GLOBAL_LOGICAL_MAX:
+                        compiler.global.logical_max = data;
+                        compiler.global.logical_max_size = size;
+                        break;
+                    case HID_GLOBAL_REPORT_SIZE:
+                        compiler.global.report_size = (uint8_t) data;
+                        break;
+                    case HID_GLOBAL_REPORT_ID:
+                        if ((data == 0) || (data > 0xff)) return false;
+                        compiler.global.report_id = (uint8_t) data;
+                        plan->has_report_ids = true;
+                        break;
+                    case HID_GLOBAL_REPORT_COUNT:
+                        compiler.global.report_count = (uint16_t) data;
+                        break;
+                    case HID_GLOBAL_PUSH:
+                        if (compiler.global_stack_depth == HID_REPORT_PLAN_MAX_PUSH_DEPTH) return false;
+                        compiler.global_stack[compiler.global_stack_depth++] = compiler.global;
+                        break;
+                    case HID_GLOBAL_POP:
+                        if (compiler.global_stack_depth == 0) return false;
+                        compiler.global = compiler.global_stack[--compiler.global_stack_depth];
+                        break;
+                    default:
+                        break;
+                }
+                break;
+            case HID_ITEM_TYPE_LOCAL:
+                // a 4 byte usage carries its own usage page
+                if (size < 4){
+                    data &= 0xffff;
+                }
+                switch (tag){
+                    case HID_LOCAL_USAGE:
+                        if (compiler.num_usages < HID_REPORT_PLAN_MAX_USAGES){
+                            compiler.usages[compiler.num_usages++] = data;
+                        }
+                        break;
+                    case HID_LOCAL_USAGE_MIN:
+                        compiler.usage_min = data;
+                        compiler.usage_range = true;
+                        break;
+                    case HID_LOCAL_USAGE_MAX:
+                        compiler.usage_max = data;
+                        compiler.usage_range = true;
+                        break;
+                    default:
+                        break;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    hid_report_plan_group_fields(plan, &compiler);
+    return true;
+}
+
+void hid_report_plan_iterator_init(hid_report_plan_iterator_t * iterator, const hid_report_plan_t * plan, const uint8_t * report, uint16_t report_len){
+    memset(iterator, 0, sizeof(hid_report_plan_iterator_t));
+    uint8_t report_id = 0;
+    if (plan->has_report_ids){
+        if (report_len < 1) return;
+        report_id = report[0];
+        report++;
+        report_len--;
+    }
+    int i;
+    for (i = 0; i < plan->num_reports; i++){
+        const hid_report_plan_report_t * entry = &plan->reports[i];
+        if (entry->report_id != report_id) continue;
+        iterator->field      = &plan->fields[entry->first_field];
+        iterator->fields_end = iterator->field + entry->num_fields;
+        iterator->data       = report;
+        iterator->data_bits  = (report_len > 0x1fff) ? 0xffff : (uint16_t) (report_len * 8);
+        return;
+    }
+}
+
+// read bit_size bits starting at bit_offset, LSB first
+static uint32_t hid_report_plan_read_bits(const uint8_t * data, uint16_t bit_offset, uint8_t bit_size){
+    const uint8_t * bytes = &data[bit_offset >> 3];
+    uint8_t shift = bit_offset & 0x07;
+    uint8_t num_bytes = (uint8_t) ((shift + bit_size + 7) >> 3);
+    uint64_t raw = 0;
+    uint8_t i;
+    for (i = 0; i < num_bytes; i++){
+        raw |= (uint64_t) bytes[i] << (8 * i);
+    }
+    raw >>= shift;
+    if (bit_size < 32){
+        raw &= (1u << bit_size) - 1;
+    }
+    return (uint32_t) raw;
+}
+
+bool hid_report_plan_iterator_has_more(hid_report_plan_iterator_t * iterator){
+    while (iterator->field < iterator->fields_end){
+        const hid_report_field_t * field = iterator->field;
+        if (iterator->slot >= field->count){
+            iterator->field++;
+            iterator->slot = 0;
+            continue;
+        }
+        uint32_t bit_offset = field->bit_offset + (uint32_t) iterator->slot * field->bit_size;
+        if (bit_offset + field->bit_size > iterator->data_bits){
+            // report shorter than described
+            iterator->field++;
+            iterator->slot = 0;
+            continue;
+        }
+        uint16_t slot = iterator->slot++;
+        uint32_t raw = hid_report_plan_read_bits(iterator->data, (uint16_t) bit_offset, field->bit_size);
+        int32_t value = (field->flags & HID_REPORT_FIELD_SIGNED) ? hid_report_plan_sign_extend(raw, field->bit_size) : (int32_t) raw;
+        iterator->usage_page = field->usage_page;
+        if (field->flags & HID_REPORT_FIELD_ARRAY){
+            // empty slot
+            if ((value < field->logical_min) || (value > field->logical_max)) continue;
+            uint32_t usage = field->usage + (uint32_t) (value - field->logical_min);
+            if ((usage == 0) || (usage > 0xffff)) continue;
+            iterator->usage = (uint16_t) usage;
+            iterator->value = 1;
+        } else {
+            iterator->usage = (uint16_t) (field->usage + slot);
+            iterator->value = value;
+        }
+        return true;
+    }
+    return false;
+}
+
+void hid_report_plan_iterator_get_field(hid_report_plan_iterator_t * iterator, uint16_t * usage_page, uint16_t * usage, int32_t * value){
+    *usage_page = iterator->usage_page;
+    *usage      = iterator->usage;
+    *value      = iterator->value;
+}
@@ -0,0 +1,111 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HID_REPORT_PLAN_H
+#define HID_REPORT_PLAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// input fields and report IDs per plan. Runs of variable fields with consecutive usages take one entry
+#define HID_REPORT_PLAN_MAX_FIELDS  48
+#define HID_REPORT_PLAN_MAX_REPORTS 16
+
+// field flags
+#define HID_REPORT_FIELD_SIGNED     0x01    // logical minimum < 0, value is sign extended
+#define HID_REPORT_FIELD_ARRAY      0x02    // each slot holds a usage index instead of a value
+
+/**
+ * One input field, or a run of equally sized fields.
+ * Variable: slot i has usage (usage + i) and the slot content as value.
+ * Array: each slot selects usage (usage + content - logical_min), reported with value 1.
+ */
+typedef struct {
+    uint16_t bit_offset;    // in report data, after the report ID
+    uint8_t  bit_size;
+    uint8_t  flags;
+    uint16_t count;         // number of slots
+    uint16_t usage_page;
+    uint16_t usage;         // variable: usage of first slot, array: usage minimum
+    int32_t  logical_min;
+    int32_t  logical_max;
+} hid_report_field_t;
+
+typedef struct {
+    uint8_t  report_id;     // 0 if the descriptor doesn't use report IDs
+    uint8_t  first_field;
+    uint8_t  num_fields;
+} hid_report_plan_report_t;
+
+/**
+ * Input report layout compiled from a HID report descriptor. Decoding a report walks only the
+ * fields of its report ID, instead of parsing the descriptor for each report again.
+ * It does not depend on the Pico SDK, so it builds on any host.
+ */
+typedef struct {
+    hid_report_field_t       fields[HID_REPORT_PLAN_MAX_FIELDS];
+    hid_report_plan_report_t reports[HID_REPORT_PLAN_MAX_REPORTS];
+    uint8_t                  num_fields;
+    uint8_t                  num_reports;
+    bool                     has_report_ids;
+} hid_report_plan_t;
+
+/**
+ * Iterates over the fields of one input report, like btstack_hid_parser_t
+ */
+typedef struct {
+    const hid_report_field_t * field;
+    const hid_report_field_t * fields_end;
+    const uint8_t *            data;        // report data after the report ID
+    uint16_t                   data_bits;
+    uint16_t                   slot;
+    // next field, valid if has_more returned true
+    uint16_t                   usage_page;
+    uint16_t                   usage;
+    int32_t                    value;
+} hid_report_plan_iterator_t;
+
+/**
+ * @brief Compile input report layout from report descriptor
+ * @param plan
+ * @param descriptor
+ * @param descriptor_len
+ * @return true if successful, false if the descriptor is malformed or exceeds the plan limits
+ */
+bool hid_report_plan_compile(hid_report_plan_t * plan, const uint8_t * descriptor, uint16_t descriptor_len);
+
+/**
+ * @brief Init iterator over input report
+ * @param iterator
+ * @param plan
+ * @param report starting with report ID if the descriptor uses them
+ * @param report_len
+ */
+void hid_report_plan_iterator_init(hid_report_plan_iterator_t * iterator, const hid_report_plan_t * plan, const uint8_t * report, uint16_t report_len);
+
+/**
+ * @brief Check if there's another field. Slots outside the report and empty array slots are skipped
+ * @param iterator
+ * @return true if get_field returns next field
+ */
+bool hid_report_plan_iterator_has_more(hid_report_plan_iterator_t * iterator);
+
+/**
+ * @brief Get next field
+ * @param iterator
+ * @param usage_page
+ * @param usage
+ * @param value
+ */
+void hid_report_plan_iterator_get_field(hid_report_plan_iterator_t * iterator, uint16_t * usage_page, uint16_t * usage, int32_t * value);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // HID_REPORT_PLAN_H
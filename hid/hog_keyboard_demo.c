@@ -0,0 +1,397 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define BTSTACK_FILE__ "hog_keyboard_demo.c"
+
+// *****************************************************************************
+/* EXAMPLE_START(hog_keyboard_demo): HID Keyboard LE (HID over GATT) with GPIO buttons
+ *
+ * @text LE variant of hid_keyboard_demo using the same report descriptor and buttons.
+ * It asks for a 7.5 ms connection interval with slave latency, so reports go out on
+ * the next connection event while an idle link skips most events.
+ * GP10 = 'd', GP11 = 'w', GP21 = 'a', GP20 = 's', GP15 = Status LED
+ */
+// *****************************************************************************
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack.h"
+#include "ble/gatt-service/battery_service_server.h"
+#include "ble/gatt-service/device_information_service_server.h"
+#include "ble/gatt-service/hids_device.h"
+
+// Add Pico SDK GPIO libraries
+#include "hardware/gpio.h"
+#include "pico/stdlib.h"
+
+#include "key_input.h"
+#include "key_latency.h"
+#include "key_state.h"
+
+// generated from hog_keyboard_demo.gatt
+#include "hog_keyboard_demo.h"
+
+// Measure latency from debounced key event to report submission, Ctrl-T on stdin prints the histograms.
+// Same stages and format as hid_keyboard_demo, to compare LE with Classic. The wait after
+// submission until the next connection event or sniff anchor is modelled by test/bench_link_latency.
+// #define ENABLE_LATENCY_STATS
+
+// LE connection parameters: intervals in 1.25 ms units, supervision timeout in 10 ms units
+#define LE_CONN_INTERVAL_MIN    6       // 7.5 ms
+#define LE_CONN_INTERVAL_MAX    6       // 7.5 ms
+#define LE_CONN_LATENCY         30      // idle link may skip up to 30 connection events (225 ms)
+#define LE_SUPERVISION_TIMEOUT  200     // 2 s
+
+// Buttons are sampled every DEBOUNCE_SAMPLE_US, an edge is accepted after DEBOUNCE_SAMPLES stable samples
+#define DEBOUNCE_SAMPLE_US 1000
+#define DEBOUNCE_SAMPLES   5
+
+// GPIO pins for buttons
+#define GPIO_BUTTON_D 10  // D key
+#define GPIO_BUTTON_W 11  // W key
+#define GPIO_BUTTON_A 21  // A key
+#define GPIO_BUTTON_S 20  // S key
+
+// GPIO pin for status LED
+#define GPIO_STATUS_LED 15  // Status LED
+
+// report ID and report descriptor, shared with the Classic keyboard. NKRO is not used over GATT
+#undef ENABLE_NKRO_REPORT
+#include "hid_descriptor_keyboard.h"
+
+// input report without report ID: modifier, reserved, keycodes
+#define REPORT_PAYLOAD_SIZE (2 + NUM_KEYS)
+
+static const uint8_t adv_data[] = {
+    // Flags general discoverable, BR/EDR not supported
+    0x02, BLUETOOTH_DATA_TYPE_FLAGS, 0x06,
+    // Name
+    0x10, BLUETOOTH_DATA_TYPE_COMPLETE_LOCAL_NAME, 'H', 'I', 'D', ' ', 'K', 'e', 'y', 'b', 'o', 'a', 'r', 'd', ' ', 'L', 'E',
+    // 16-bit Service UUIDs
+    0x03, BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS, ORG_BLUETOOTH_SERVICE_HUMAN_INTERFACE_DEVICE & 0xff, ORG_BLUETOOTH_SERVICE_HUMAN_INTERFACE_DEVICE >> 8,
+    // Appearance HID - Keyboard (Category 15, Sub-Category 1)
+    0x03, BLUETOOTH_DATA_TYPE_APPEARANCE, 0xC1, 0x03,
+};
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static btstack_packet_callback_registration_t sm_event_callback_registration;
+static hci_con_handle_t con_handle = HCI_CON_HANDLE_INVALID;
+static uint8_t protocol_mode = 1;   // 0 = boot, 1 = report
+static bool    report_pending;
+
+// input report characteristics the host enabled notifications for, reports are only sent while one is
+#define INPUT_REPORT_ENABLED_REPORT 1
+#define INPUT_REPORT_ENABLED_BOOT   2
+static uint8_t input_reports_enabled;
+
+// Key state: all keys currently held, sent together in one input report
+static key_state_t key_state;
+
+// GPIO buttons, active low
+static const key_input_button_t buttons[] = {
+    { GPIO_BUTTON_D, 0x07 },    // d
+    { GPIO_BUTTON_W, 0x1a },    // w
+    { GPIO_BUTTON_A, 0x04 },    // a
+    { GPIO_BUTTON_S, 0x16 },    // s
+};
+
+#define NUM_BUTTONS (sizeof(buttons) / sizeof(key_input_button_t))
+
+static key_input_buttons_t key_input_buttons;
+static repeating_timer_t   button_sample_timer;
+
+// Key events from interrupt context, processed on the run loop
+typedef struct {
+    uint8_t  keycode;
+    bool     pressed;
+#ifdef ENABLE_LATENCY_STATS
+    uint32_t timestamp_us;                  // time_us_32() when posted
+#endif
+} key_event_t;
+
+#define KEY_EVENT_QUEUE_SIZE 32     // power of two
+static key_event_t       key_event_storage[KEY_EVENT_QUEUE_SIZE];
+static key_input_queue_t key_event_queue;
+
+#ifdef ENABLE_LATENCY_STATS
+#define CHAR_DUMP_STATS 0x14    // Ctrl-T
+
+static key_latency_t         key_latency;
+static btstack_data_source_t stdin_command_data_source;
+#endif
+
+static void update_status_led(void){
+    gpio_put(GPIO_STATUS_LED, con_handle != HCI_CON_HANDLE_INVALID);
+}
+
+static void send_report(void){
+    // same layout as boot keyboard report
+    uint8_t payload[REPORT_PAYLOAD_SIZE];
+    key_state_compose_keys(&key_state, payload, NUM_KEYS);
+    if (protocol_mode == 0){
+        hids_device_send_boot_keyboard_input_report(con_handle, payload, sizeof(payload));
+    } else {
+        hids_device_send_input_report_for_id(con_handle, REPORT_ID, payload, sizeof(payload));
+    }
+#ifdef ENABLE_LATENCY_STATS
+    key_latency_report_sent(&key_latency, time_us_32());
+#endif
+}
+
+// request CAN_SEND_NOW, the report sent then reflects all changes up to that point
+static void request_report(void){
+    if (report_pending) return;
+    report_pending = true;
+#ifdef ENABLE_LATENCY_STATS
+    key_latency_report_requested(&key_latency, time_us_32());
+#endif
+    hids_device_request_can_send_now_event(con_handle);
+}
+
+static void can_send_now(void){
+    report_pending = false;
+    // notifications got disabled while waiting
+    if (input_reports_enabled == 0) return;
+#ifdef ENABLE_LATENCY_STATS
+    key_latency_can_send_now(&key_latency, time_us_32());
+#endif
+    send_report();
+}
+
+#ifdef ENABLE_LATENCY_STATS
+static void stdin_command_process(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(ds);
+    UNUSED(callback_type);
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT){
+        if (c == CHAR_DUMP_STATS){
+            key_latency_dump(&key_latency, "LE");
+        }
+    }
+}
+
+// called from USB interrupt when new characters arrive
+static void stdin_chars_available(void * context){
+    UNUSED(context);
+    btstack_run_loop_poll_data_sources_from_irq();
+}
+#endif
+
+// debounced key press or release, on run loop
+static void key_event(const key_event_t * event){
+    if (con_handle == HCI_CON_HANDLE_INVALID) return;
+#ifdef ENABLE_LATENCY_STATS
+    key_latency_key_event(&key_latency, event->timestamp_us, time_us_32());
+#endif
+    if (event->pressed){
+        key_state_press(&key_state, event->keycode);
+    } else {
+        key_state_release(&key_state, event->keycode);
+    }
+    if (input_reports_enabled == 0) return;
+    request_report();
+}
+
+static void key_event_process(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(ds);
+    UNUSED(callback_type);
+    key_event_t event;
+    while (key_input_queue_get(&key_event_queue, &event)){
+        key_event(&event);
+    }
+    key_input_queue_report_overflows(&key_event_queue);
+}
+
+// queue key event in interrupt context
+static void key_event_post(uint8_t keycode, bool pressed){
+    key_event_t event;
+    event.keycode = keycode;
+    event.pressed = pressed;
+#ifdef ENABLE_LATENCY_STATS
+    event.timestamp_us = time_us_32();
+#endif
+    key_input_queue_post(&key_event_queue, &event);
+}
+
+// Periodic timer in interrupt context: sample all buttons at once and debounce them
+static bool button_sample_callback(repeating_timer_t * rt){
+    UNUSED(rt);
+    if (key_input_buttons_sample(&key_input_buttons, &key_event_post)){
+        // wake up run loop
+        btstack_run_loop_poll_data_sources_from_irq();
+    }
+    return true;
+}
+
+static void init_gpio(void){
+    gpio_init(GPIO_STATUS_LED);
+    gpio_set_dir(GPIO_STATUS_LED, GPIO_OUT);
+    gpio_put(GPIO_STATUS_LED, 0);
+
+    key_input_queue_init(&key_event_queue, key_event_storage, sizeof(key_event_t), KEY_EVENT_QUEUE_SIZE, &key_event_process);
+    key_input_buttons_init(&key_input_buttons, buttons, NUM_BUTTONS, DEBOUNCE_SAMPLES);
+    add_repeating_timer_us(-DEBOUNCE_SAMPLE_US, &button_sample_callback, NULL, &button_sample_timer);
+}
+
+// notifications for the report or the boot keyboard characteristic got enabled or disabled
+static void input_report_enable(uint8_t characteristic, uint8_t enable){
+    bool was_enabled = input_reports_enabled != 0;
+    if (enable){
+        input_reports_enabled |= characteristic;
+    } else {
+        input_reports_enabled &= ~characteristic;
+    }
+    update_status_led();
+    if (was_enabled == (input_reports_enabled != 0)) return;
+    if (input_reports_enabled){
+        // key state was tracked meanwhile, bring the host up to date
+        request_report();
+    } else {
+        report_pending = false;
+    }
+}
+
+// connection interval in 1.25 ms units
+static void log_connection_parameters(const char * reason, uint16_t conn_interval, uint16_t conn_latency){
+    printf("%s: connection interval %u.%02u ms, slave latency %u\n", reason,
+           conn_interval * 125 / 100, (conn_interval * 125) % 100, conn_latency);
+}
+
+static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    uint16_t conn_interval;
+
+    if (packet_type != HCI_EVENT_PACKET) return;
+
+    switch (hci_event_packet_get_type(packet)){
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) return;
+            printf("BTstack ready, advertising as HID Keyboard LE.\n");
+            break;
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            con_handle = HCI_CON_HANDLE_INVALID;
+            input_reports_enabled = 0;
+            report_pending = false;
+            key_state_clear(&key_state);
+            update_status_led();
+            printf("Disconnected\n");
+            break;
+        case SM_EVENT_JUST_WORKS_REQUEST:
+            printf("Just Works requested\n");
+            sm_just_works_confirm(sm_event_just_works_request_get_handle(packet));
+            break;
+        case HCI_EVENT_LE_META:
+            switch (hci_event_le_meta_get_subevent_code(packet)){
+                case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
+                    conn_interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
+                    log_connection_parameters("Connected", conn_interval, hci_subevent_le_connection_complete_get_conn_latency(packet));
+                    if (conn_interval > LE_CONN_INTERVAL_MAX){
+                        // ask central for short interval, it may still pick something else
+                        gap_request_connection_parameter_update(hci_subevent_le_connection_complete_get_connection_handle(packet),
+                            LE_CONN_INTERVAL_MIN, LE_CONN_INTERVAL_MAX, LE_CONN_LATENCY, LE_SUPERVISION_TIMEOUT);
+                    }
+                    break;
+                case HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE:
+                    log_connection_parameters("Connection update",
+                        hci_subevent_le_connection_update_complete_get_conn_interval(packet),
+                        hci_subevent_le_connection_update_complete_get_conn_latency(packet));
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case HCI_EVENT_HIDS_META:
+            switch (hci_event_hids_meta_get_subevent_code(packet)){
+                case HIDS_SUBEVENT_INPUT_REPORT_ENABLE:
+                    con_handle = hids_subevent_input_report_enable_get_con_handle(packet);
+                    input_report_enable(INPUT_REPORT_ENABLED_REPORT, hids_subevent_input_report_enable_get_enable(packet));
+                    printf("Report characteristic subscribed %u\n", hids_subevent_input_report_enable_get_enable(packet));
+                    break;
+                case HIDS_SUBEVENT_BOOT_KEYBOARD_INPUT_REPORT_ENABLE:
+                    con_handle = hids_subevent_boot_keyboard_input_report_enable_get_con_handle(packet);
+                    input_report_enable(INPUT_REPORT_ENABLED_BOOT, hids_subevent_boot_keyboard_input_report_enable_get_enable(packet));
+                    printf("Boot Keyboard Characteristic Subscribed %u\n", hids_subevent_boot_keyboard_input_report_enable_get_enable(packet));
+                    break;
+                case HIDS_SUBEVENT_PROTOCOL_MODE:
+                    protocol_mode = hids_subevent_protocol_mode_get_protocol_mode(packet);
+                    printf("Protocol Mode: %s mode\n", protocol_mode ? "Report" : "Boot");
+                    break;
+                case HIDS_SUBEVENT_CAN_SEND_NOW:
+                    can_send_now();
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+int btstack_main(int argc, const char * argv[]){
+    (void)argc;
+    (void)argv;
+
+    printf("\n\nHID Keyboard LE Demo with GPIO Buttons Starting...\n");
+
+    init_gpio();
+
+    l2cap_init();
+
+    // setup SM: Just Works with bonding
+    sm_init();
+    sm_set_io_capabilities(IO_CAPABILITY_NO_INPUT_NO_OUTPUT);
+    sm_set_authentication_requirements(SM_AUTHREQ_SECURE_CONNECTION | SM_AUTHREQ_BONDING);
+
+    // setup ATT server
+    att_server_init(profile_data, NULL, NULL);
+
+    // setup battery service
+    battery_service_server_init(100);
+
+    // setup device information service
+    device_information_service_server_init();
+
+    // setup HID Device service
+    hids_device_init(0, hid_descriptor_keyboard, sizeof(hid_descriptor_keyboard));
+
+    // setup advertisements
+    uint16_t adv_int_min = 0x0030;
+    uint16_t adv_int_max = 0x0030;
+    uint8_t adv_type = 0;
+    bd_addr_t null_addr;
+    memset(null_addr, 0, 6);
+    gap_advertisements_set_params(adv_int_min, adv_int_max, adv_type, 0, null_addr, 0x07, 0x00);
+    gap_advertisements_set_data(sizeof(adv_data), (uint8_t *) adv_data);
+    gap_advertisements_enable(1);
+
+    // register for HCI events
+    hci_event_callback_registration.callback = &packet_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+
+    // register for SM events
+    sm_event_callback_registration.callback = &packet_handler;
+    sm_add_event_handler(&sm_event_callback_registration);
+
+    // register for HIDS
+    hids_device_register_packet_handler(packet_handler);
+
+#ifdef ENABLE_LATENCY_STATS
+    btstack_run_loop_set_data_source_handler(&stdin_command_data_source, &stdin_command_process);
+    btstack_run_loop_enable_data_source_callbacks(&stdin_command_data_source, DATA_SOURCE_CALLBACK_POLL);
+    btstack_run_loop_add_data_source(&stdin_command_data_source);
+    stdio_set_chars_available_callback(&stdin_chars_available, NULL);
+#endif
+
+    // turn on!
+    hci_power_control(HCI_POWER_ON);
+
+    return 0;
+}
+/* EXAMPLE_END */
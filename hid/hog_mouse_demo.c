@@ -0,0 +1,318 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define BTSTACK_FILE__ "hog_mouse_demo.c"
+
+// *****************************************************************************
+/* EXAMPLE_START(hog_mouse_demo): HID Mouse LE (HID over GATT)
+ *
+ * @text LE variant of hid_mouse_demo using the same boot mode report descriptor.
+ * Like the embedded Classic mouse, it simulates clicking on 4 corners of a square.
+ * It asks for a 7.5 ms connection interval with slave latency.
+ */
+// *****************************************************************************
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack.h"
+#include "ble/gatt-service/battery_service_server.h"
+#include "ble/gatt-service/device_information_service_server.h"
+#include "ble/gatt-service/hids_device.h"
+
+// generated from hog_mouse_demo.gatt
+#include "hog_mouse_demo.h"
+
+// LE connection parameters: intervals in 1.25 ms units, supervision timeout in 10 ms units
+#define LE_CONN_INTERVAL_MIN    6       // 7.5 ms
+#define LE_CONN_INTERVAL_MAX    6       // 7.5 ms
+#define LE_CONN_LATENCY         30      // idle link may skip up to 30 connection events (225 ms)
+#define LE_SUPERVISION_TIMEOUT  200     // 2 s
+
+// report descriptor, shared with the Classic mouse
+#include "hid_descriptor_mouse.h"
+
+static const uint8_t adv_data[] = {
+    // Flags general discoverable, BR/EDR not supported
+    0x02, BLUETOOTH_DATA_TYPE_FLAGS, 0x06,
+    // Name
+    0x0d, BLUETOOTH_DATA_TYPE_COMPLETE_LOCAL_NAME, 'H', 'I', 'D', ' ', 'M', 'o', 'u', 's', 'e', ' ', 'L', 'E',
+    // 16-bit Service UUIDs
+    0x03, BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS, ORG_BLUETOOTH_SERVICE_HUMAN_INTERFACE_DEVICE & 0xff, ORG_BLUETOOTH_SERVICE_HUMAN_INTERFACE_DEVICE >> 8,
+    // Appearance HID - Mouse (Category 15, Sub-Category 2)
+    0x03, BLUETOOTH_DATA_TYPE_APPEARANCE, 0xC2, 0x03,
+};
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static btstack_packet_callback_registration_t sm_event_callback_registration;
+static hci_con_handle_t con_handle = HCI_CON_HANDLE_INVALID;
+static uint8_t protocol_mode = 1;   // 0 = boot, 1 = report
+
+// movement not reported yet
+static int dx;
+static int dy;
+static uint8_t buttons;
+static bool report_pending;
+
+// input report characteristics the host enabled notifications for, reports are only sent while one is
+#define INPUT_REPORT_ENABLED_REPORT 1
+#define INPUT_REPORT_ENABLED_BOOT   2
+static uint8_t input_reports_enabled;
+
+// HID Report sending, boot and report protocol use the same layout
+static void send_report(uint8_t buttons, int8_t dx, int8_t dy){
+    uint8_t report[] = { buttons, (uint8_t) dx, (uint8_t) dy };
+    if (protocol_mode == 0){
+        hids_device_send_boot_mouse_input_report(con_handle, report, sizeof(report));
+    } else {
+        hids_device_send_input_report(con_handle, report, sizeof(report));
+    }
+    printf("Mouse: %d/%d - buttons: %02x\n", dx, dy, buttons);
+}
+
+// request CAN_SEND_NOW, movement until then goes into the same report
+static void mousing_request_report(void){
+    if (report_pending) return;
+    report_pending = true;
+    hids_device_request_can_send_now_event(con_handle);
+}
+
+// take as much of the accumulated movement as fits into one report, the remainder stays for the next one
+static int8_t mousing_take_delta(int * accumulator){
+    int delta = *accumulator;
+    if (delta >  127) delta =  127;
+    if (delta < -127) delta = -127;
+    *accumulator -= delta;
+    return (int8_t) delta;
+}
+
+static void mousing_can_send_now(void){
+    report_pending = false;
+    // notifications got disabled while waiting
+    if (input_reports_enabled == 0) return;
+    int8_t report_dx = mousing_take_delta(&dx);
+    int8_t report_dy = mousing_take_delta(&dy);
+    send_report(buttons, report_dx, report_dy);
+    // click is released in the next report, which also carries remaining movement
+    if (buttons || dx || dy){
+        buttons = 0;
+        mousing_request_report();
+    }
+}
+
+// Simulate clicking on 4 corners of a square
+
+#define MOUSE_PERIOD_MS 15
+
+static int step;
+static const int STEPS_PER_DIRECTION = 50;
+static const int MOUSE_SPEED = 10;
+
+static struct {
+    int dx;
+    int dy;
+} directions[] = {
+    {  1,  0 },
+    {  0,  1 },
+    { -1,  0 },
+    {  0, -1 },
+};
+
+static btstack_timer_source_t mousing_timer;
+
+static void mousing_timer_handler(btstack_timer_source_t * ts){
+
+    if (con_handle == HCI_CON_HANDLE_INVALID) return;
+
+    // simulate left click when corner reached
+    if (step % STEPS_PER_DIRECTION == 0){
+        buttons |= 1;
+    }
+    // simulate move
+    int direction_index = step / STEPS_PER_DIRECTION;
+    dx += directions[direction_index].dx * MOUSE_SPEED;
+    dy += directions[direction_index].dy * MOUSE_SPEED;
+
+    // next
+    step++;
+    if (step >= STEPS_PER_DIRECTION * 4) {
+        step = 0;
+    }
+
+    // trigger send
+    mousing_request_report();
+
+    // set next timer
+    btstack_run_loop_set_timer(ts, MOUSE_PERIOD_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+static void hid_embedded_start_mousing(void){
+    printf("Start mousing..\n");
+
+    step = 0;
+
+    // set one-shot timer
+    mousing_timer.process = &mousing_timer_handler;
+    btstack_run_loop_set_timer(&mousing_timer, MOUSE_PERIOD_MS);
+    btstack_run_loop_add_timer(&mousing_timer);
+}
+
+static void hid_embedded_stop_mousing(void){
+    btstack_run_loop_remove_timer(&mousing_timer);
+    report_pending = false;
+    dx = 0;
+    dy = 0;
+    buttons = 0;
+}
+
+// notifications for the report or the boot mouse characteristic got enabled or disabled
+static void hid_embedded_input_report_enable(hci_con_handle_t handle, uint8_t characteristic, uint8_t enable){
+    bool was_enabled = input_reports_enabled != 0;
+    if (enable){
+        input_reports_enabled |= characteristic;
+    } else {
+        input_reports_enabled &= ~characteristic;
+    }
+    if (was_enabled == (input_reports_enabled != 0)) return;
+    if (input_reports_enabled){
+        con_handle = handle;
+        hid_embedded_start_mousing();
+    } else {
+        printf("Stop mousing, notifications disabled\n");
+        hid_embedded_stop_mousing();
+    }
+}
+
+// connection interval in 1.25 ms units
+static void log_connection_parameters(const char * reason, uint16_t conn_interval, uint16_t conn_latency){
+    printf("%s: connection interval %u.%02u ms, slave latency %u\n", reason,
+           conn_interval * 125 / 100, (conn_interval * 125) % 100, conn_latency);
+}
+
+static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    uint16_t conn_interval;
+
+    if (packet_type != HCI_EVENT_PACKET) return;
+
+    switch (hci_event_packet_get_type(packet)){
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) return;
+            printf("BTstack ready, advertising as HID Mouse LE.\n");
+            break;
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            con_handle = HCI_CON_HANDLE_INVALID;
+            input_reports_enabled = 0;
+            hid_embedded_stop_mousing();
+            printf("Disconnected\n");
+            break;
+        case SM_EVENT_JUST_WORKS_REQUEST:
+            printf("Just Works requested\n");
+            sm_just_works_confirm(sm_event_just_works_request_get_handle(packet));
+            break;
+        case HCI_EVENT_LE_META:
+            switch (hci_event_le_meta_get_subevent_code(packet)){
+                case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
+                    conn_interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
+                    log_connection_parameters("Connected", conn_interval, hci_subevent_le_connection_complete_get_conn_latency(packet));
+                    if (conn_interval > LE_CONN_INTERVAL_MAX){
+                        // ask central for short interval, it may still pick something else
+                        gap_request_connection_parameter_update(hci_subevent_le_connection_complete_get_connection_handle(packet),
+                            LE_CONN_INTERVAL_MIN, LE_CONN_INTERVAL_MAX, LE_CONN_LATENCY, LE_SUPERVISION_TIMEOUT);
+                    }
+                    break;
+                case HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE:
+                    log_connection_parameters("Connection update",
+                        hci_subevent_le_connection_update_complete_get_conn_interval(packet),
+                        hci_subevent_le_connection_update_complete_get_conn_latency(packet));
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case HCI_EVENT_HIDS_META:
+            switch (hci_event_hids_meta_get_subevent_code(packet)){
+                case HIDS_SUBEVENT_INPUT_REPORT_ENABLE:
+                    printf("Report characteristic subscribed %u\n", hids_subevent_input_report_enable_get_enable(packet));
+                    hid_embedded_input_report_enable(hids_subevent_input_report_enable_get_con_handle(packet),
+                        INPUT_REPORT_ENABLED_REPORT, hids_subevent_input_report_enable_get_enable(packet));
+                    break;
+                case HIDS_SUBEVENT_BOOT_MOUSE_INPUT_REPORT_ENABLE:
+                    printf("Boot Mouse Characteristic Subscribed %u\n", hids_subevent_boot_mouse_input_report_enable_get_enable(packet));
+                    hid_embedded_input_report_enable(hids_subevent_boot_mouse_input_report_enable_get_con_handle(packet),
+                        INPUT_REPORT_ENABLED_BOOT, hids_subevent_boot_mouse_input_report_enable_get_enable(packet));
+                    break;
+                case HIDS_SUBEVENT_PROTOCOL_MODE:
+                    protocol_mode = hids_subevent_protocol_mode_get_protocol_mode(packet);
+                    printf("Protocol Mode: %s mode\n", protocol_mode ? "Report" : "Boot");
+                    break;
+                case HIDS_SUBEVENT_CAN_SEND_NOW:
+                    mousing_can_send_now();
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+int btstack_main(int argc, const char * argv[]){
+    (void)argc;
+    (void)argv;
+
+    printf("\n\nHID Mouse LE Demo Starting...\n");
+
+    l2cap_init();
+
+    // setup SM: Just Works with bonding
+    sm_init();
+    sm_set_io_capabilities(IO_CAPABILITY_NO_INPUT_NO_OUTPUT);
+    sm_set_authentication_requirements(SM_AUTHREQ_SECURE_CONNECTION | SM_AUTHREQ_BONDING);
+
+    // setup ATT server
+    att_server_init(profile_data, NULL, NULL);
+
+    // setup battery service
+    battery_service_server_init(100);
+
+    // setup device information service
+    device_information_service_server_init();
+
+    // setup HID Device service
+    hids_device_init(0, hid_descriptor_mouse_boot_mode, sizeof(hid_descriptor_mouse_boot_mode));
+
+    // setup advertisements
+    uint16_t adv_int_min = 0x0030;
+    uint16_t adv_int_max = 0x0030;
+    uint8_t adv_type = 0;
+    bd_addr_t null_addr;
+    memset(null_addr, 0, 6);
+    gap_advertisements_set_params(adv_int_min, adv_int_max, adv_type, 0, null_addr, 0x07, 0x00);
+    gap_advertisements_set_data(sizeof(adv_data), (uint8_t *) adv_data);
+    gap_advertisements_enable(1);
+
+    // register for HCI events
+    hci_event_callback_registration.callback = &packet_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
+
+    // register for SM events
+    sm_event_callback_registration.callback = &packet_handler;
+    sm_add_event_handler(&sm_event_callback_registration);
+
+    // register for HIDS
+    hids_device_register_packet_handler(packet_handler);
+
+    // turn on!
+    hci_power_control(HCI_POWER_ON);
+
+    return 0;
+}
+/* EXAMPLE_END */
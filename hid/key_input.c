@@ -0,0 +1,63 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "key_input.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hardware/gpio.h"
+
+void key_input_buttons_init(key_input_buttons_t * buttons, const key_input_button_t * table, uint8_t num_buttons, uint8_t debounce_samples){
+    memset(buttons, 0, sizeof(key_input_buttons_t));
+    buttons->buttons = table;
+    uint32_t button_mask = 0;
+    uint8_t i;
+    for (i = 0; i < num_buttons; i++){
+        uint8_t gpio = table[i].gpio;
+        gpio_init(gpio);
+        gpio_set_dir(gpio, GPIO_IN);
+        gpio_pull_up(gpio);
+        buttons->button_index_for_gpio[gpio] = i;
+        button_mask |= 1u << gpio;
+    }
+    debounce_init(&buttons->debounce, button_mask, debounce_samples);
+}
+
+bool key_input_buttons_sample(key_input_buttons_t * buttons, void (*callback)(uint8_t keycode, bool pressed)){
+    // buttons are active low
+    uint32_t changed = debounce_update(&buttons->debounce, ~gpio_get_all());
+    if (changed == 0) return false;
+    uint32_t state = debounce_get_state(&buttons->debounce);
+    while (changed){
+        uint8_t gpio = (uint8_t) __builtin_ctz(changed);
+        changed &= changed - 1;
+        (*callback)(buttons->buttons[buttons->button_index_for_gpio[gpio]].keycode, (state & (1u << gpio)) != 0);
+    }
+    return true;
+}
+
+void key_input_queue_init(key_input_queue_t * queue, void * storage, uint16_t event_size, uint32_t capacity,
+                          void (*process)(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type)){
+    spsc_queue_init(&queue->queue, storage, event_size, capacity);
+    queue->overflows_reported = 0;
+    btstack_run_loop_set_data_source_handler(&queue->data_source, process);
+    btstack_run_loop_enable_data_source_callbacks(&queue->data_source, DATA_SOURCE_CALLBACK_POLL);
+    btstack_run_loop_add_data_source(&queue->data_source);
+}
+
+bool key_input_queue_post(key_input_queue_t * queue, const void * event){
+    return spsc_queue_put(&queue->queue, event);
+}
+
+bool key_input_queue_get(key_input_queue_t * queue, void * event){
+    return spsc_queue_get(&queue->queue, event);
+}
+
+void key_input_queue_report_overflows(key_input_queue_t * queue){
+    uint32_t overflows = spsc_queue_get_overflows(&queue->queue);
+    if (overflows == queue->overflows_reported) return;
+    queue->overflows_reported = overflows;
+    printf("Key event queue full, %u events dropped\n", (unsigned int) overflows);
+}
@@ -0,0 +1,97 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef KEY_INPUT_H
+#define KEY_INPUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "btstack.h"
+#include "debounce.h"
+#include "spsc_queue.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Input side shared by the Classic and the LE keyboard: GPIO buttons sampled together
+ * and debounced, and the queue that hands key events from interrupt context or core1
+ * to the BTstack run loop.
+ */
+
+// GPIO button, active low
+typedef struct {
+    uint8_t gpio;
+    uint8_t keycode;
+} key_input_button_t;
+
+typedef struct {
+    const key_input_button_t * buttons;
+    debounce_t                 debounce;
+    uint8_t                    button_index_for_gpio[32];
+} key_input_buttons_t;
+
+typedef struct {
+    spsc_queue_t          queue;
+    btstack_data_source_t data_source;
+    uint32_t              overflows_reported;
+} key_input_queue_t;
+
+/**
+ * @brief Configure GPIOs as inputs with pull-up and init debouncer, all buttons start released
+ * @param buttons
+ * @param table of buttons, must stay valid
+ * @param num_buttons
+ * @param debounce_samples for an edge to be accepted
+ */
+void key_input_buttons_init(key_input_buttons_t * buttons, const key_input_button_t * table, uint8_t num_buttons, uint8_t debounce_samples);
+
+/**
+ * @brief Sample all buttons at once and debounce them, e.g. from a periodic timer
+ * @param buttons
+ * @param callback for each debounced press or release
+ * @return true if callback was called
+ */
+bool key_input_buttons_sample(key_input_buttons_t * buttons, void (*callback)(uint8_t keycode, bool pressed));
+
+/**
+ * @brief Init queue and register its data source with the run loop
+ * @param queue
+ * @param storage for capacity key events
+ * @param event_size
+ * @param capacity number of key events, must be a power of two
+ * @param process called on the run loop after btstack_run_loop_poll_data_sources_from_irq()
+ */
+void key_input_queue_init(key_input_queue_t * queue, void * storage, uint16_t event_size, uint32_t capacity,
+                          void (*process)(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type));
+
+/**
+ * @brief Add key event, producer only
+ * @param queue
+ * @param event
+ * @return false if queue was full
+ */
+bool key_input_queue_post(key_input_queue_t * queue, const void * event);
+
+/**
+ * @brief Remove oldest key event, run loop only
+ * @param queue
+ * @param event
+ * @return false if queue was empty
+ */
+bool key_input_queue_get(key_input_queue_t * queue, void * event);
+
+/**
+ * @brief Log key events dropped since last call, run loop only
+ * @param queue
+ */
+void key_input_queue_report_overflows(key_input_queue_t * queue);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // KEY_INPUT_H
@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "key_latency.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char * key_latency_stage_names[KEY_LATENCY_STAGE_COUNT] = {
+    "queue",
+    "can send now",
+    "total",
+};
+
+void key_latency_init(key_latency_t * latency){
+    memset(latency, 0, sizeof(key_latency_t));
+}
+
+void key_latency_key_event(key_latency_t * latency, uint32_t posted_us, uint32_t now_us){
+    latency_histogram_add(&latency->histograms[KEY_LATENCY_STAGE_QUEUE], now_us - posted_us);
+    if (latency->input_pending) return;
+    latency->input_pending = true;
+    latency->input_us = posted_us;
+}
+
+void key_latency_report_requested(key_latency_t * latency, uint32_t now_us){
+    latency->request_us = now_us;
+}
+
+void key_latency_can_send_now(key_latency_t * latency, uint32_t now_us){
+    latency_histogram_add(&latency->histograms[KEY_LATENCY_STAGE_CAN_SEND_NOW], now_us - latency->request_us);
+}
+
+void key_latency_report_sent(key_latency_t * latency, uint32_t now_us){
+    if (latency->input_pending == false) return;
+    latency->input_pending = false;
+    latency_histogram_add(&latency->histograms[KEY_LATENCY_STAGE_TOTAL], now_us - latency->input_us);
+}
+
+const latency_histogram_t * key_latency_get_histogram(const key_latency_t * latency, key_latency_stage_t stage){
+    return &latency->histograms[stage];
+}
+
+void key_latency_dump(const key_latency_t * latency, const char * transport){
+    printf("Latency over %s\n", transport);
+    printf("Latency (us)       count     p50     p99     max\n");
+    int i;
+    for (i = 0; i < KEY_LATENCY_STAGE_COUNT; i++){
+        const latency_histogram_t * histogram = &latency->histograms[i];
+        printf("%-14s %9u %7u %7u %7u\n", key_latency_stage_names[i],
+               (unsigned int) latency_histogram_get_count(histogram),
+               (unsigned int) latency_histogram_get_percentile(histogram, 50),
+               (unsigned int) latency_histogram_get_percentile(histogram, 99),
+               (unsigned int) latency_histogram_get_max(histogram));
+    }
+}
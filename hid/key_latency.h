@@ -0,0 +1,92 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef KEY_LATENCY_H
+#define KEY_LATENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "latency_histogram.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// latency stages, all in us
+typedef enum {
+    KEY_LATENCY_STAGE_QUEUE = 0,    // key event posted -> processed on run loop
+    KEY_LATENCY_STAGE_CAN_SEND_NOW, // report requested -> CAN_SEND_NOW
+    KEY_LATENCY_STAGE_TOTAL,        // key event posted -> report submitted
+    KEY_LATENCY_STAGE_COUNT
+} key_latency_stage_t;
+
+/**
+ * Latency from debounced key event to report submission, split into the stages above.
+ * The Classic and the LE keyboard record the same stages and print them in the same
+ * format, so their dumps can be compared line by line.
+ * Times are passed in, so it does not depend on the Pico SDK and builds on any host.
+ */
+typedef struct {
+    latency_histogram_t histograms[KEY_LATENCY_STAGE_COUNT];
+    bool                input_pending;      // key event not yet reflected in a sent report
+    uint32_t            input_us;           // oldest such key event
+    uint32_t            request_us;         // CAN_SEND_NOW requested
+} key_latency_t;
+
+/**
+ * @brief Reset all stages
+ * @param latency
+ */
+void key_latency_init(key_latency_t * latency);
+
+/**
+ * @brief Call when a key event is processed on the run loop
+ * @param latency
+ * @param posted_us time the key event was posted
+ * @param now_us
+ */
+void key_latency_key_event(key_latency_t * latency, uint32_t posted_us, uint32_t now_us);
+
+/**
+ * @brief Call when CAN_SEND_NOW is requested for a report
+ * @param latency
+ * @param now_us
+ */
+void key_latency_report_requested(key_latency_t * latency, uint32_t now_us);
+
+/**
+ * @brief Call on CAN_SEND_NOW
+ * @param latency
+ * @param now_us
+ */
+void key_latency_can_send_now(key_latency_t * latency, uint32_t now_us);
+
+/**
+ * @brief Call right after a report was handed to the stack
+ * @param latency
+ * @param now_us
+ */
+void key_latency_report_sent(key_latency_t * latency, uint32_t now_us);
+
+/**
+ * @brief Get histogram of a stage
+ * @param latency
+ * @param stage
+ * @return histogram
+ */
+const latency_histogram_t * key_latency_get_histogram(const key_latency_t * latency, key_latency_stage_t stage);
+
+/**
+ * @brief Print count, p50, p99 and max of all stages
+ * @param latency
+ * @param transport printed in the header, e.g. "Classic" or "LE"
+ */
+void key_latency_dump(const key_latency_t * latency, const char * transport);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // KEY_LATENCY_H
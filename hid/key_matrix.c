@@ -0,0 +1,67 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "key_matrix.h"
+
+#include <string.h>
+
+void key_matrix_init(key_matrix_t * matrix, uint8_t num_rows, uint8_t num_cols, uint8_t debounce_samples){
+    memset(matrix, 0, sizeof(key_matrix_t));
+    matrix->num_rows = num_rows;
+    uint32_t col_mask = (num_cols >= 32) ? 0xffffffff : ((1u << num_cols) - 1);
+    int row;
+    for (row = 0; row < num_rows; row++){
+        debounce_init(&matrix->debounce[row], col_mask, debounce_samples);
+    }
+}
+
+bool key_matrix_update(key_matrix_t * matrix, const uint32_t * snapshot, key_matrix_callback_t callback, void * context){
+    uint32_t debounced[KEY_MATRIX_MAX_ROWS];
+    uint32_t changed_rows = 0;
+    int row;
+
+    for (row = 0; row < matrix->num_rows; row++){
+        if (debounce_update(&matrix->debounce[row], snapshot[row])){
+            changed_rows |= 1u << row;
+        }
+        debounced[row] = debounce_get_state(&matrix->debounce[row]);
+    }
+
+    // fast path: no debounced change and no presses held back by ghosting
+    if (changed_rows == 0) {
+        for (row = 0; row < matrix->num_rows; row++){
+            if (debounced[row] != matrix->state[row]) break;
+        }
+        if (row == matrix->num_rows) return false;
+    }
+
+    // rows sharing at least two columns form a rectangle, one of its corners may be a ghost
+    uint32_t ghost_rows = 0;
+    int other;
+    for (row = 0; row < matrix->num_rows; row++){
+        if ((debounced[row] & (debounced[row] - 1)) == 0) continue;
+        for (other = row + 1; other < matrix->num_rows; other++){
+            uint32_t common = debounced[row] & debounced[other];
+            if (common & (common - 1)){
+                ghost_rows |= (1u << row) | (1u << other);
+            }
+        }
+    }
+
+    for (row = 0; row < matrix->num_rows; row++){
+        uint32_t next = debounced[row];
+        if (ghost_rows & (1u << row)){
+            // ambiguous: accept releases only
+            next &= matrix->state[row];
+        }
+        uint32_t changed = next ^ matrix->state[row];
+        matrix->state[row] = next;
+        while (changed){
+            uint8_t col = (uint8_t) __builtin_ctz(changed);
+            changed &= changed - 1;
+            (*callback)((uint8_t) row, col, (next & (1u << col)) != 0, context);
+        }
+    }
+    return ghost_rows != 0;
+}
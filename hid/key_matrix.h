@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef KEY_MATRIX_H
+#define KEY_MATRIX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "debounce.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#define KEY_MATRIX_MAX_ROWS 16
+
+/**
+ * Debouncing, ghost detection and diffing for key matrix snapshots. It does not depend
+ * on the Pico SDK, so it builds on any host.
+ *
+ * Without a diode per key, three keys pressed on the corners of a rectangle make the fourth
+ * corner read as pressed too. This shows up as two rows sharing two or more columns.
+ * As long as that is the case, keys in these rows can be released but not pressed.
+ */
+typedef struct {
+    uint8_t    num_rows;
+    uint32_t   state[KEY_MATRIX_MAX_ROWS];      // reported keys, bit n = column n
+    debounce_t debounce[KEY_MATRIX_MAX_ROWS];
+} key_matrix_t;
+
+/**
+ * @brief Callback for key press/release
+ * @param row
+ * @param col
+ * @param pressed
+ * @param context
+ */
+typedef void (*key_matrix_callback_t)(uint8_t row, uint8_t col, bool pressed, void * context);
+
+/**
+ * @brief Init key matrix, all keys released
+ * @param matrix
+ * @param num_rows up to KEY_MATRIX_MAX_ROWS
+ * @param num_cols up to 32
+ * @param debounce_samples number of samples for an edge to be accepted
+ */
+void key_matrix_init(key_matrix_t * matrix, uint8_t num_rows, uint8_t num_cols, uint8_t debounce_samples);
+
+/**
+ * @brief Process one snapshot and report changed keys
+ * @param matrix
+ * @param snapshot with num_rows entries, bit n is set if the key in column n reads pressed
+ * @param callback for each key that was pressed or released
+ * @param context passed to callback
+ * @return true if ghosting was detected
+ */
+bool key_matrix_update(key_matrix_t * matrix, const uint32_t * snapshot, key_matrix_callback_t callback, void * context);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // KEY_MATRIX_H
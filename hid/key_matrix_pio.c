@@ -0,0 +1,118 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "key_matrix_pio.h"
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+
+#include "key_matrix.pio.h"
+
+// PIO cycles per row, see key_matrix.pio
+#define KEY_MATRIX_PIO_CYCLES_PER_ROW 36
+
+static uint     key_matrix_num_rows;
+static uint32_t key_matrix_col_mask;
+
+// one-hot row patterns, read by DMA
+static uint32_t key_matrix_row_patterns[KEY_MATRIX_PIO_MAX_ROWS];
+// raw column samples per row, written by DMA
+static volatile uint32_t key_matrix_samples[KEY_MATRIX_PIO_MAX_ROWS];
+
+// start addresses, reloaded by the control channels after each scan
+static const uint32_t * key_matrix_row_patterns_addr = key_matrix_row_patterns;
+static volatile uint32_t * key_matrix_samples_addr = key_matrix_samples;
+
+void key_matrix_pio_init(uint row_base, uint num_rows, uint col_base, uint num_cols, uint32_t scan_rate_hz){
+    uint i;
+
+    key_matrix_num_rows = num_rows;
+    key_matrix_col_mask = (1u << num_cols) - 1;
+    for (i = 0; i < num_rows; i++){
+        key_matrix_row_patterns[i] = 1u << i;
+    }
+
+    // the CYW43 driver also uses PIO, take whichever instance has room
+    PIO pio;
+    uint sm;
+    uint offset;
+    bool ok = pio_claim_free_sm_and_add_program(&key_matrix_program, &pio, &sm, &offset);
+    hard_assert(ok);
+
+    // rows: output low when selected, floating otherwise
+    uint32_t row_mask = ((1u << num_rows) - 1) << row_base;
+    for (i = 0; i < num_rows; i++){
+        pio_gpio_init(pio, row_base + i);
+    }
+    pio_sm_set_pins_with_mask(pio, sm, 0, row_mask);
+    pio_sm_set_pindirs_with_mask(pio, sm, 0, row_mask);
+
+    // columns: inputs with pull-up
+    for (i = 0; i < num_cols; i++){
+        gpio_init(col_base + i);
+        gpio_set_dir(col_base + i, GPIO_IN);
+        gpio_pull_up(col_base + i);
+    }
+
+    pio_sm_config c = key_matrix_program_get_default_config(offset);
+    sm_config_set_out_pins(&c, row_base, num_rows);
+    sm_config_set_in_pins(&c, col_base);
+    sm_config_set_out_shift(&c, true, false, 32);
+    sm_config_set_in_shift(&c, true, false, 32);
+    float cycles_per_second = (float) scan_rate_hz * num_rows * KEY_MATRIX_PIO_CYCLES_PER_ROW;
+    sm_config_set_clkdiv(&c, (float) clock_get_hz(clk_sys) / cycles_per_second);
+    pio_sm_init(pio, sm, offset, &c);
+
+    // DMA: a data channel transfers one scan, then chains to a control channel that
+    // rewrites the data channel's start address, which triggers the next scan
+    int tx_data = dma_claim_unused_channel(true);
+    int tx_ctrl = dma_claim_unused_channel(true);
+    int rx_data = dma_claim_unused_channel(true);
+    int rx_ctrl = dma_claim_unused_channel(true);
+
+    dma_channel_config cfg = dma_channel_get_default_config(tx_data);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(pio, sm, true));
+    channel_config_set_chain_to(&cfg, tx_ctrl);
+    dma_channel_configure(tx_data, &cfg, &pio->txf[sm], key_matrix_row_patterns, num_rows, false);
+
+    cfg = dma_channel_get_default_config(tx_ctrl);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, false);
+    dma_channel_configure(tx_ctrl, &cfg, &dma_hw->ch[tx_data].al3_read_addr_trig, &key_matrix_row_patterns_addr, 1, false);
+
+    cfg = dma_channel_get_default_config(rx_data);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, pio_get_dreq(pio, sm, false));
+    channel_config_set_chain_to(&cfg, rx_ctrl);
+    dma_channel_configure(rx_data, &cfg, key_matrix_samples, &pio->rxf[sm], num_rows, false);
+
+    cfg = dma_channel_get_default_config(rx_ctrl);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, false);
+    dma_channel_configure(rx_ctrl, &cfg, &dma_hw->ch[rx_data].al2_write_addr_trig, &key_matrix_samples_addr, 1, false);
+
+    // all keys released until the first scan completes
+    for (i = 0; i < num_rows; i++){
+        key_matrix_samples[i] = 0xffffffff;
+    }
+
+    dma_start_channel_mask((1u << tx_data) | (1u << rx_data));
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+void key_matrix_pio_get_snapshot(uint32_t * snapshot){
+    uint i;
+    for (i = 0; i < key_matrix_num_rows; i++){
+        // columns are active low
+        snapshot[i] = ~key_matrix_samples[i] & key_matrix_col_mask;
+    }
+}
@@ -0,0 +1,40 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef KEY_MATRIX_PIO_H
+#define KEY_MATRIX_PIO_H
+
+#include <stdint.h>
+
+#include "hardware/pio.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#define KEY_MATRIX_PIO_MAX_ROWS 16
+
+/**
+ * @brief Start scanning a key matrix with a PIO state machine. Row patterns are fed and
+ * column samples are collected by DMA, so the snapshot is updated continuously at
+ * scan_rate_hz without CPU involvement.
+ * @param row_base first row GPIO, rows are consecutive
+ * @param num_rows up to KEY_MATRIX_PIO_MAX_ROWS
+ * @param col_base first column GPIO, columns are consecutive
+ * @param num_cols
+ * @param scan_rate_hz full matrix scans per second
+ */
+void key_matrix_pio_init(uint row_base, uint num_rows, uint col_base, uint num_cols, uint32_t scan_rate_hz);
+
+/**
+ * @brief Copy latest snapshot
+ * @param snapshot with num_rows entries, bit n is set if the key in column n is pressed
+ */
+void key_matrix_pio_get_snapshot(uint32_t * snapshot);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // KEY_MATRIX_PIO_H
@@ -0,0 +1,54 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "key_state.h"
+
+#include <string.h>
+
+void key_state_clear(key_state_t * state){
+    memset(state, 0, sizeof(key_state_t));
+}
+
+void key_state_press(key_state_t * state, uint8_t keycode){
+    if (keycode >= KEY_STATE_RESERVED_FIRST) return;
+    if (keycode >= 0xe0){
+        state->modifier |= 1 << (keycode - 0xe0);
+    } else {
+        state->pressed[keycode >> 3] |= 1 << (keycode & 0x07);
+    }
+}
+
+void key_state_release(key_state_t * state, uint8_t keycode){
+    if (keycode >= KEY_STATE_RESERVED_FIRST) return;
+    if (keycode >= 0xe0){
+        state->modifier &= ~(1 << (keycode - 0xe0));
+    } else {
+        state->pressed[keycode >> 3] &= ~(1 << (keycode & 0x07));
+    }
+}
+
+void key_state_compose_keys(const key_state_t * state, uint8_t * payload, uint8_t num_keys){
+    memset(payload, 0, 2 + num_keys);
+    payload[0] = state->modifier;
+    int count = 0;
+    int i;
+    for (i = 0; i < KEY_STATE_BITMAP_SIZE; i++){
+        uint8_t bits = state->pressed[i];
+        while (bits){
+            uint8_t bit = __builtin_ctz(bits);
+            bits &= bits - 1;
+            if (count == num_keys){
+                // more keys held than fit into the report: report ErrorRollOver for all of them
+                memset(&payload[2], 0x01, num_keys);
+                return;
+            }
+            payload[2 + count++] = (uint8_t) ((i << 3) | bit);
+        }
+    }
+}
+
+void key_state_compose_bitmap(const key_state_t * state, uint8_t * payload, uint8_t bitmap_size){
+    payload[0] = state->modifier;
+    memcpy(&payload[1], state->pressed, bitmap_size);
+}
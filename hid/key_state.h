@@ -0,0 +1,71 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef KEY_STATE_H
+#define KEY_STATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#define KEY_STATE_BITMAP_SIZE 32
+
+// keycodes from 0xe8 on are reserved by the keyboard usage page, inputs taken from them are not keys
+#define KEY_STATE_RESERVED_FIRST 0xe8
+
+/**
+ * All keys currently held, sent together in one input report. Modifiers (0xe0-0xe7) are
+ * kept as the modifier byte, all other keycodes in a bitmap.
+ * It does not depend on the Pico SDK, so it builds on any host.
+ */
+typedef struct {
+    uint8_t modifier;
+    uint8_t pressed[KEY_STATE_BITMAP_SIZE];
+} key_state_t;
+
+/**
+ * @brief Release all keys
+ * @param state
+ */
+void key_state_clear(key_state_t * state);
+
+/**
+ * @brief Mark key as held, reserved keycodes are ignored
+ * @param state
+ * @param keycode
+ */
+void key_state_press(key_state_t * state, uint8_t keycode);
+
+/**
+ * @brief Mark key as released, reserved keycodes are ignored
+ * @param state
+ * @param keycode
+ */
+void key_state_release(key_state_t * state, uint8_t keycode);
+
+/**
+ * @brief Compose boot keyboard layout: modifier, reserved, num_keys keycodes.
+ * If more keys are held than fit, all keycodes are ErrorRollOver (0x01).
+ * @param state
+ * @param payload of 2 + num_keys bytes
+ * @param num_keys
+ */
+void key_state_compose_keys(const key_state_t * state, uint8_t * payload, uint8_t num_keys);
+
+/**
+ * @brief Compose NKRO layout: modifier, bitmap of keycodes 0..8 * bitmap_size - 1
+ * @param state
+ * @param payload of 1 + bitmap_size bytes
+ * @param bitmap_size up to KEY_STATE_BITMAP_SIZE
+ */
+void key_state_compose_bitmap(const key_state_t * state, uint8_t * payload, uint8_t bitmap_size);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // KEY_STATE_H
@@ -0,0 +1,102 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef KEYTABLE_US_H
+#define KEYTABLE_US_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Character to keycode translation for the keyboard demo. It does not depend on the Pico SDK,
+// so the host tests can check it against the keycode -> character tables.
+
+#define CHAR_RETURN     '\n'
+#define CHAR_ESCAPE      27
+#define CHAR_TAB         '\t'
+#define CHAR_BACKSPACE   0x7f
+
+// Simplified US Keyboard with Shift modifier
+
+#define MODIFIER_NONE    0x00
+#define MODIFIER_SHIFT   0x02   // Left Shift
+
+typedef struct {
+    uint8_t keycode;    // 0 = character cannot be typed
+    uint8_t modifier;
+} keycode_and_modifier_t;
+
+/**
+ * English (US), indexed by character
+ *
+ * Reverse of the keycode -> character tables used by the HID host demo, so that
+ * translating a character is a single lookup. The table is const and lives in flash.
+ * If a character is reachable by several keys, the unshifted one is used, and
+ * '*' and '+' are sent from the keypad so they don't need a modifier.
+ */
+static const keycode_and_modifier_t keytable_us[256] = {
+    // letters
+    ['a'] = {   4, MODIFIER_NONE  }, ['b'] = {   5, MODIFIER_NONE  }, ['c'] = {   6, MODIFIER_NONE  },
+    ['d'] = {   7, MODIFIER_NONE  }, ['e'] = {   8, MODIFIER_NONE  }, ['f'] = {   9, MODIFIER_NONE  },
+    ['g'] = {  10, MODIFIER_NONE  }, ['h'] = {  11, MODIFIER_NONE  }, ['i'] = {  12, MODIFIER_NONE  },
+    ['j'] = {  13, MODIFIER_NONE  }, ['k'] = {  14, MODIFIER_NONE  }, ['l'] = {  15, MODIFIER_NONE  },
+    ['m'] = {  16, MODIFIER_NONE  }, ['n'] = {  17, MODIFIER_NONE  }, ['o'] = {  18, MODIFIER_NONE  },
+    ['p'] = {  19, MODIFIER_NONE  }, ['q'] = {  20, MODIFIER_NONE  }, ['r'] = {  21, MODIFIER_NONE  },
+    ['s'] = {  22, MODIFIER_NONE  }, ['t'] = {  23, MODIFIER_NONE  }, ['u'] = {  24, MODIFIER_NONE  },
+    ['v'] = {  25, MODIFIER_NONE  }, ['w'] = {  26, MODIFIER_NONE  }, ['x'] = {  27, MODIFIER_NONE  },
+    ['y'] = {  28, MODIFIER_NONE  }, ['z'] = {  29, MODIFIER_NONE  },
+    // shifted letters
+    ['A'] = {   4, MODIFIER_SHIFT }, ['B'] = {   5, MODIFIER_SHIFT }, ['C'] = {   6, MODIFIER_SHIFT },
+    ['D'] = {   7, MODIFIER_SHIFT }, ['E'] = {   8, MODIFIER_SHIFT }, ['F'] = {   9, MODIFIER_SHIFT },
+    ['G'] = {  10, MODIFIER_SHIFT }, ['H'] = {  11, MODIFIER_SHIFT }, ['I'] = {  12, MODIFIER_SHIFT },
+    ['J'] = {  13, MODIFIER_SHIFT }, ['K'] = {  14, MODIFIER_SHIFT }, ['L'] = {  15, MODIFIER_SHIFT },
+    ['M'] = {  16, MODIFIER_SHIFT }, ['N'] = {  17, MODIFIER_SHIFT }, ['O'] = {  18, MODIFIER_SHIFT },
+    ['P'] = {  19, MODIFIER_SHIFT }, ['Q'] = {  20, MODIFIER_SHIFT }, ['R'] = {  21, MODIFIER_SHIFT },
+    ['S'] = {  22, MODIFIER_SHIFT }, ['T'] = {  23, MODIFIER_SHIFT }, ['U'] = {  24, MODIFIER_SHIFT },
+    ['V'] = {  25, MODIFIER_SHIFT }, ['W'] = {  26, MODIFIER_SHIFT }, ['X'] = {  27, MODIFIER_SHIFT },
+    ['Y'] = {  28, MODIFIER_SHIFT }, ['Z'] = {  29, MODIFIER_SHIFT },
+    // digits
+    ['1'] = {  30, MODIFIER_NONE  }, ['2'] = {  31, MODIFIER_NONE  }, ['3'] = {  32, MODIFIER_NONE  },
+    ['4'] = {  33, MODIFIER_NONE  }, ['5'] = {  34, MODIFIER_NONE  }, ['6'] = {  35, MODIFIER_NONE  },
+    ['7'] = {  36, MODIFIER_NONE  }, ['8'] = {  37, MODIFIER_NONE  }, ['9'] = {  38, MODIFIER_NONE  },
+    ['0'] = {  39, MODIFIER_NONE  },
+    // shifted digits
+    ['!'] = {  30, MODIFIER_SHIFT }, ['@'] = {  31, MODIFIER_SHIFT }, ['#'] = {  32, MODIFIER_SHIFT },
+    ['$'] = {  33, MODIFIER_SHIFT }, ['%'] = {  34, MODIFIER_SHIFT }, ['^'] = {  35, MODIFIER_SHIFT },
+    ['&'] = {  36, MODIFIER_SHIFT }, ['('] = {  38, MODIFIER_SHIFT }, [')'] = {  39, MODIFIER_SHIFT },
+    // control and whitespace
+    [CHAR_RETURN]    = {  40, MODIFIER_NONE  }, [CHAR_ESCAPE] = {  41, MODIFIER_NONE  },
+    [CHAR_BACKSPACE] = {  42, MODIFIER_NONE  }, [CHAR_TAB]    = {  43, MODIFIER_NONE  },
+    [' ']            = {  44, MODIFIER_NONE  },
+    // punctuation
+    ['-'] = {  45, MODIFIER_NONE  }, ['='] = {  46, MODIFIER_NONE  }, ['['] = {  47, MODIFIER_NONE  },
+    [']'] = {  48, MODIFIER_NONE  }, ['\\'] = {  49, MODIFIER_NONE  }, [';'] = {  51, MODIFIER_NONE  },
+    ['\''] = {  52, MODIFIER_NONE  }, ['`'] = {  53, MODIFIER_NONE  }, [','] = {  54, MODIFIER_NONE  },
+    ['.'] = {  55, MODIFIER_NONE  }, ['/'] = {  56, MODIFIER_NONE  },
+    // shifted punctuation
+    ['_'] = {  45, MODIFIER_SHIFT }, ['{'] = {  47, MODIFIER_SHIFT }, ['}'] = {  48, MODIFIER_SHIFT },
+    ['|'] = {  49, MODIFIER_SHIFT }, [':'] = {  51, MODIFIER_SHIFT }, ['"'] = {  52, MODIFIER_SHIFT },
+    ['~'] = {  53, MODIFIER_SHIFT }, ['<'] = {  54, MODIFIER_SHIFT }, ['>'] = {  55, MODIFIER_SHIFT },
+    ['?'] = {  56, MODIFIER_SHIFT },
+    // keypad
+    ['*'] = {  85, MODIFIER_NONE  }, ['+'] = {  87, MODIFIER_NONE  },
+    // non-US backslash
+    [0xa7] = { 100, MODIFIER_NONE  }, [0xb1] = { 100, MODIFIER_SHIFT },
+};
+
+/**
+ * @brief Get keycode and modifier to type a character
+ * @param character
+ * @param keycode
+ * @param modifier
+ * @return false if the character cannot be typed
+ */
+static inline bool keytable_us_lookup(uint8_t character, uint8_t * keycode, uint8_t * modifier){
+    const keycode_and_modifier_t * entry = &keytable_us[character];
+    if (entry->keycode == 0) return false;
+    *keycode  = entry->keycode;
+    *modifier = entry->modifier;
+    return true;
+}
+
+#endif // KEYTABLE_US_H
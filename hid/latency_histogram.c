@@ -0,0 +1,66 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "latency_histogram.h"
+
+#include <string.h>
+
+// values below 4 have their own bucket, above that the two bits after the MSB select one of 4 sub-buckets
+static uint32_t latency_histogram_bucket(uint32_t latency_us){
+    if (latency_us < 4) return latency_us;
+    uint32_t msb = 31 - __builtin_clz(latency_us);
+    uint32_t bucket = 4 * (msb - 1) + ((latency_us >> (msb - 2)) & 3);
+    if (bucket >= LATENCY_HISTOGRAM_BUCKETS){
+        bucket = LATENCY_HISTOGRAM_BUCKETS - 1;
+    }
+    return bucket;
+}
+
+static uint32_t latency_histogram_bucket_upper_bound(uint32_t bucket){
+    if (bucket < 4) return bucket;
+    uint32_t msb = bucket / 4 + 1;
+    uint32_t lower = (4 + (bucket & 3)) << (msb - 2);
+    return lower + (1u << (msb - 2)) - 1;
+}
+
+void latency_histogram_init(latency_histogram_t * histogram){
+    memset(histogram, 0, sizeof(latency_histogram_t));
+}
+
+void latency_histogram_add(latency_histogram_t * histogram, uint32_t latency_us){
+    histogram->buckets[latency_histogram_bucket(latency_us)]++;
+    histogram->count++;
+    if (latency_us > histogram->max){
+        histogram->max = latency_us;
+    }
+}
+
+uint32_t latency_histogram_get_percentile(const latency_histogram_t * histogram, uint32_t percent){
+    if (histogram->count == 0) return 0;
+    // rank of the sample at percent, 1..count
+    uint32_t rank = (uint32_t) (((uint64_t) histogram->count * percent + 99) / 100);
+    if (rank == 0){
+        rank = 1;
+    }
+    uint32_t seen = 0;
+    uint32_t bucket;
+    for (bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; bucket++){
+        seen += histogram->buckets[bucket];
+        if (seen >= rank) break;
+    }
+    // the last bucket is open-ended, and no bucket bound should exceed the largest sample
+    uint32_t upper_bound = latency_histogram_bucket_upper_bound(bucket);
+    if ((bucket == LATENCY_HISTOGRAM_BUCKETS - 1) || (upper_bound > histogram->max)){
+        upper_bound = histogram->max;
+    }
+    return upper_bound;
+}
+
+uint32_t latency_histogram_get_count(const latency_histogram_t * histogram){
+    return histogram->count;
+}
+
+uint32_t latency_histogram_get_max(const latency_histogram_t * histogram){
+    return histogram->max;
+}
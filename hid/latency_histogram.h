@@ -0,0 +1,68 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// 4 buckets per power of two from 4 us up to 2^24 us (~16 s), larger values go into the last bucket
+#define LATENCY_HISTOGRAM_BUCKETS 92
+
+/**
+ * Fixed-bucket latency histogram in microseconds. Adding a sample is O(1) and needs no
+ * allocation, so it can be used on the send path. Percentiles are reported as the upper
+ * bound of the bucket they fall into, which is within 25% of the exact value.
+ * It does not depend on the Pico SDK, so it builds on any host.
+ */
+typedef struct {
+    uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+    uint32_t count;
+    uint32_t max;
+} latency_histogram_t;
+
+/**
+ * @brief Init empty histogram
+ * @param histogram
+ */
+void latency_histogram_init(latency_histogram_t * histogram);
+
+/**
+ * @brief Add sample
+ * @param histogram
+ * @param latency_us
+ */
+void latency_histogram_add(latency_histogram_t * histogram, uint32_t latency_us);
+
+/**
+ * @brief Get percentile
+ * @param histogram
+ * @param percent 0..100
+ * @return upper bound of the bucket containing the percentile, 0 if empty
+ */
+uint32_t latency_histogram_get_percentile(const latency_histogram_t * histogram, uint32_t percent);
+
+/**
+ * @brief Get number of samples
+ * @param histogram
+ * @return count
+ */
+uint32_t latency_histogram_get_count(const latency_histogram_t * histogram);
+
+/**
+ * @brief Get largest sample
+ * @param histogram
+ * @return max latency in us
+ */
+uint32_t latency_histogram_get_max(const latency_histogram_t * histogram);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // LATENCY_HISTOGRAM_H
@@ -8,16 +8,22 @@
 #include "pico/stdlib.h"
 #include "btstack_run_loop.h"
 
+#include "boot_trace.h"
+
 int btstack_main(int argc, const char * argv[]);
 
 int main() {
+    // startup messages are printed while USB enumerates, keep them until the host opens the port
+    boot_trace_defer_output();
     stdio_init_all();
+    boot_trace_mark("stdio init");
 
     // initialize CYW43 driver
     if (cyw43_arch_init()) {
         printf("cyw43_arch_init() failed.\n");
         return -1;
     }
+    boot_trace_mark("cyw43 init");
 
     // run the app
     btstack_main(0, NULL);
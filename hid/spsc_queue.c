@@ -0,0 +1,41 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "spsc_queue.h"
+
+#include <string.h>
+
+void spsc_queue_init(spsc_queue_t * queue, void * storage, uint16_t element_size, uint32_t capacity){
+    memset(queue, 0, sizeof(spsc_queue_t));
+    queue->storage = (uint8_t *) storage;
+    queue->element_size = element_size;
+    queue->capacity = capacity;
+}
+
+bool spsc_queue_put(spsc_queue_t * queue, const void * element){
+    uint32_t head = queue->head;
+    // acquire: element at tail must have been read before its slot gets reused
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if ((head - tail) == queue->capacity){
+        __atomic_store_n(&queue->overflows, queue->overflows + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    memcpy(&queue->storage[(head & (queue->capacity - 1)) * queue->element_size], element, queue->element_size);
+    // release: element is complete before the consumer sees the new head
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool spsc_queue_get(spsc_queue_t * queue, void * element){
+    uint32_t tail = queue->tail;
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    if (head == tail) return false;
+    memcpy(element, &queue->storage[(tail & (queue->capacity - 1)) * queue->element_size], queue->element_size);
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t spsc_queue_get_overflows(const spsc_queue_t * queue){
+    return __atomic_load_n(&queue->overflows, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,68 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Lock-free single-producer/single-consumer queue of fixed size elements.
+ *
+ * The producer may run in interrupt context or on the other core, the consumer on the
+ * BTstack run loop. Head is only written by the producer and tail only by the consumer,
+ * both are free running counters, so neither side needs to disable interrupts.
+ * If the queue is full, put() fails and the element is counted in overflows.
+ */
+typedef struct {
+    uint8_t * storage;
+    uint16_t  element_size;
+    uint32_t  capacity;             // power of two
+    uint32_t  head;                 // next element to write, producer only
+    uint32_t  tail;                 // next element to read, consumer only
+    uint32_t  overflows;            // elements dropped, producer only
+} spsc_queue_t;
+
+/**
+ * @brief Init queue
+ * @param queue
+ * @param storage for capacity * element_size bytes
+ * @param element_size
+ * @param capacity number of elements, must be a power of two
+ */
+void spsc_queue_init(spsc_queue_t * queue, void * storage, uint16_t element_size, uint32_t capacity);
+
+/**
+ * @brief Add element, producer only
+ * @param queue
+ * @param element
+ * @return false if queue was full
+ */
+bool spsc_queue_put(spsc_queue_t * queue, const void * element);
+
+/**
+ * @brief Remove oldest element, consumer only
+ * @param queue
+ * @param element
+ * @return false if queue was empty
+ */
+bool spsc_queue_get(spsc_queue_t * queue, void * element);
+
+/**
+ * @brief Get number of elements that were dropped because the queue was full
+ * @param queue
+ * @return overflows
+ */
+uint32_t spsc_queue_get_overflows(const spsc_queue_t * queue);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,121 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Input report decoding over the descriptor corpus: report plan, and btstack_hid_parser if BTstack
+// is available. Also the one-time cost of compiling the plan.
+
+#include <stdlib.h>
+
+#include "test_check.h"
+#include "hid_descriptor_corpus.h"
+#include "hid_report_plan.h"
+
+#ifdef HAVE_BTSTACK_HID_PARSER
+#include "btstack_hid_parser.h"
+#endif
+
+#define BENCH_REPORTS   64          // different reports per report ID, decoded in turn
+#define BENCH_ROUNDS    20000
+#define BENCH_COMPILES  20000
+
+// checksum over all fields, keeps the loops from being optimized away and shows if both decoders agree
+static volatile uint32_t checksum;
+
+static uint8_t reports[BENCH_REPORTS][64];
+
+static void reports_init(const hid_descriptor_corpus_entry_t * entry, uint8_t index){
+    int i;
+    for (i = 0; i < BENCH_REPORTS; i++){
+        int j;
+        for (j = 0; j < entry->report_lens[index]; j++){
+            reports[i][j] = (uint8_t) rand();
+        }
+        if (entry->report_ids[index] != 0){
+            reports[i][0] = entry->report_ids[index];
+        }
+    }
+}
+
+static double bench_plan(const hid_report_plan_t * plan, uint16_t report_len){
+    uint32_t sum = 0;
+    double start_ns = test_now_ns();
+    int round;
+    for (round = 0; round < BENCH_ROUNDS; round++){
+        hid_report_plan_iterator_t iterator;
+        hid_report_plan_iterator_init(&iterator, plan, reports[round % BENCH_REPORTS], report_len);
+        while (hid_report_plan_iterator_has_more(&iterator)){
+            uint16_t usage_page;
+            uint16_t usage;
+            int32_t  value;
+            hid_report_plan_iterator_get_field(&iterator, &usage_page, &usage, &value);
+            sum += usage_page + usage + (uint32_t) value;
+        }
+    }
+    checksum = sum;
+    return (test_now_ns() - start_ns) / BENCH_ROUNDS;
+}
+
+#ifdef HAVE_BTSTACK_HID_PARSER
+static double bench_parser(const hid_descriptor_corpus_entry_t * entry, uint16_t report_len){
+    uint32_t sum = 0;
+    double start_ns = test_now_ns();
+    int round;
+    for (round = 0; round < BENCH_ROUNDS; round++){
+        btstack_hid_parser_t parser;
+        btstack_hid_parser_init(&parser, entry->descriptor, entry->descriptor_len, HID_REPORT_TYPE_INPUT,
+                                reports[round % BENCH_REPORTS], report_len);
+        while (btstack_hid_parser_has_more(&parser)){
+            uint16_t usage_page;
+            uint16_t usage;
+            int32_t  value;
+            btstack_hid_parser_get_field(&parser, &usage_page, &usage, &value);
+            sum += usage_page + usage + (uint32_t) value;
+        }
+    }
+    checksum = sum;
+    return (test_now_ns() - start_ns) / BENCH_ROUNDS;
+}
+#endif
+
+static double bench_compile(const hid_descriptor_corpus_entry_t * entry){
+    static hid_report_plan_t plan;
+    double start_ns = test_now_ns();
+    int i;
+    for (i = 0; i < BENCH_COMPILES; i++){
+        hid_report_plan_compile(&plan, entry->descriptor, entry->descriptor_len);
+        checksum = plan.num_fields;
+    }
+    return (test_now_ns() - start_ns) / BENCH_COMPILES;
+}
+
+int main(void){
+    srand(1);
+#ifdef HAVE_BTSTACK_HID_PARSER
+    printf("%-16s %9s %6s %11s %13s\n", "descriptor", "report ID", "bytes", "plan ns", "parser ns");
+#else
+    printf("%-16s %9s %6s %11s   (btstack_hid_parser not found, set BTSTACK_ROOT to compare)\n", "descriptor", "report ID", "bytes", "plan ns");
+#endif
+    unsigned int e;
+    for (e = 0; e < HID_DESCRIPTOR_CORPUS_SIZE; e++){
+        const hid_descriptor_corpus_entry_t * entry = &hid_descriptor_corpus[e];
+        hid_report_plan_t plan;
+        if (hid_report_plan_compile(&plan, entry->descriptor, entry->descriptor_len) == false){
+            printf("%s: compile failed\n", entry->name);
+            return 1;
+        }
+        uint8_t r;
+        for (r = 0; r < entry->num_reports; r++){
+            reports_init(entry, r);
+            double plan_ns = bench_plan(&plan, entry->report_lens[r]);
+#ifdef HAVE_BTSTACK_HID_PARSER
+            double parser_ns = bench_parser(entry, entry->report_lens[r]);
+            printf("%-16s %9u %6u %11.1f %13.1f\n", entry->name, entry->report_ids[r], entry->report_lens[r], plan_ns, parser_ns);
+#else
+            printf("%-16s %9u %6u %11.1f\n", entry->name, entry->report_ids[r], entry->report_lens[r], plan_ns);
+#endif
+        }
+        printf("%-16s compile %.1f ns, %u fields\n", entry->name, bench_compile(entry), plan.num_fields);
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// key_matrix_update() per snapshot: idle matrix (fast path), typing, and held keys with ghosting
+
+#include <string.h>
+
+#include "test_check.h"
+#include "key_matrix.h"
+
+// 16 x 8 = 128 keys, more than the demo's 9 x 7
+#define MATRIX_ROWS      16
+#define MATRIX_COLS      8
+#define DEBOUNCE_SAMPLES 5
+
+#define BENCH_SNAPSHOTS  1000000
+
+static volatile uint32_t events;
+
+static void count_event(uint8_t row, uint8_t col, bool pressed, void * context){
+    (void) row;
+    (void) col;
+    (void) pressed;
+    (void) context;
+    events++;
+}
+
+// snapshot for step: typing presses a different key every 40 snapshots (40 ms at 1 kHz)
+static void snapshot_typing(uint32_t * snapshot, int step){
+    memset(snapshot, 0, MATRIX_ROWS * sizeof(uint32_t));
+    int key = (step / 40) % (MATRIX_ROWS * MATRIX_COLS);
+    if ((step % 40) < 20){
+        snapshot[key / MATRIX_COLS] = 1u << (key % MATRIX_COLS);
+    }
+}
+
+static double bench(const char * name, void (*snapshot_for_step)(uint32_t * snapshot, int step)){
+    key_matrix_t matrix;
+    key_matrix_init(&matrix, MATRIX_ROWS, MATRIX_COLS, DEBOUNCE_SAMPLES);
+    uint32_t snapshot[MATRIX_ROWS];
+    events = 0;
+    double start_ns = test_now_ns();
+    int step;
+    for (step = 0; step < BENCH_SNAPSHOTS; step++){
+        (*snapshot_for_step)(snapshot, step);
+        key_matrix_update(&matrix, snapshot, &count_event, NULL);
+    }
+    double ns = (test_now_ns() - start_ns) / BENCH_SNAPSHOTS;
+    printf("key_matrix %-8s %6.1f ns/snapshot, %u events\n", name, ns, (unsigned int) events);
+    return ns;
+}
+
+static void snapshot_idle(uint32_t * snapshot, int step){
+    (void) step;
+    memset(snapshot, 0, MATRIX_ROWS * sizeof(uint32_t));
+}
+
+// two rows sharing two columns in every row pair, releases only
+static void snapshot_ghost(uint32_t * snapshot, int step){
+    (void) step;
+    int row;
+    for (row = 0; row < MATRIX_ROWS; row++){
+        snapshot[row] = 0x03;
+    }
+}
+
+int main(void){
+    bench("idle", &snapshot_idle);
+    bench("typing", &snapshot_typing);
+    bench("ghost", &snapshot_ghost);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Character -> keycode translation: keytable_us lookup vs. previous two-table scan
+
+#include <string.h>
+
+#include "test_check.h"
+#include "keytable_us_scan.h"
+
+#define BENCH_ROUNDS 20000
+
+static const char bench_text[] = "The quick brown fox jumps over the lazy dog. THE QUICK BROWN FOX! 0123456789 ~{}|:\"<>?\n";
+
+int main(void){
+    size_t len = strlen(bench_text);
+    volatile uint32_t sink = 0;
+    uint8_t keycode = 0;
+    uint8_t modifier = 0;
+    int round;
+    size_t i;
+
+    double start_ns = test_now_ns();
+    for (round = 0; round < BENCH_ROUNDS; round++){
+        for (i = 0; i < len; i++){
+            if (keytable_us_scan((uint8_t) bench_text[i], &keycode, &modifier)){
+                sink += keycode + modifier;
+            }
+        }
+    }
+    double scan_ns = (test_now_ns() - start_ns) / ((double) BENCH_ROUNDS * len);
+
+    start_ns = test_now_ns();
+    for (round = 0; round < BENCH_ROUNDS; round++){
+        for (i = 0; i < len; i++){
+            if (keytable_us_lookup((uint8_t) bench_text[i], &keycode, &modifier)){
+                sink += keycode + modifier;
+            }
+        }
+    }
+    double lookup_ns = (test_now_ns() - start_ns) / ((double) BENCH_ROUNDS * len);
+
+    printf("keytable_us: two-table scan %.2f ns/char, table lookup %.2f ns/char (checksum %u)\n",
+           scan_ns, lookup_ns, (unsigned int) sink);
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Classic vs LE: wait from report submission until the link can carry it.
+//
+// ENABLE_LATENCY_STATS in hid_keyboard_demo and hog_keyboard_demo prints the same stages
+// for both transports, ending when the report is handed to the stack. The report then
+// waits in the controller for the next transmit opportunity of the link, which the
+// device cannot timestamp. This models that wait for the links the demos configure:
+// a sniffing Classic slave can only send at its sniff anchors, an active one when polled,
+// and an LE peripheral at the next connection event. Slave latency doesn't add to it,
+// since the peripheral may use any event once it has data.
+// This is a model, not a measurement: add it to the on-device totals of each transport.
+
+#include <stdlib.h>
+
+#include "test_check.h"
+#include "latency_histogram.h"
+
+#define NUM_REPORTS 100000
+
+typedef struct {
+    const char * name;
+    uint32_t     interval_us;   // time between transmit opportunities
+} link_t;
+
+static const link_t links[] = {
+    { "Classic active, Tpoll 25 ms",  25000 },     // default max poll interval of 40 slots
+    { "Classic sniff 100 ms",        100000 },     // SNIFF_MIN_INTERVAL
+    { "Classic sniff 500 ms",        500000 },     // SNIFF_MAX_INTERVAL
+    { "LE 7.5 ms, latency 30",         7500 },     // LE_CONN_INTERVAL_MAX, LE_CONN_LATENCY
+    { "LE 30 ms (central default)",   30000 },     // if the central rejects the update request
+};
+
+int main(void){
+    srand(1);
+    printf("Wait for next transmit opportunity (us), model\n");
+    printf("%-28s %9s %7s %7s %7s\n", "link", "count", "p50", "p99", "max");
+    unsigned int l;
+    for (l = 0; l < sizeof(links) / sizeof(links[0]); l++){
+        latency_histogram_t histogram;
+        latency_histogram_init(&histogram);
+        int i;
+        for (i = 0; i < NUM_REPORTS; i++){
+            // key presses are not aligned to the link: submission falls anywhere in the interval
+            uint32_t phase_us = (uint32_t) (((uint64_t) rand() * links[l].interval_us) / ((uint64_t) RAND_MAX + 1));
+            latency_histogram_add(&histogram, links[l].interval_us - phase_us);
+        }
+        printf("%-28s %9u %7u %7u %7u\n", links[l].name,
+               (unsigned int) latency_histogram_get_count(&histogram),
+               (unsigned int) latency_histogram_get_percentile(&histogram, 50),
+               (unsigned int) latency_histogram_get_percentile(&histogram, 99),
+               (unsigned int) latency_histogram_get_max(&histogram));
+    }
+    return 0;
+}
@@ -0,0 +1,11 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BTSTACK_CONFIG_H
+#define BTSTACK_CONFIG_H
+
+// Host build of btstack_hid_parser.c and btstack_util.c for the report plan tests: no logging,
+// no HCI, so nothing beyond these two files has to be linked.
+
+#endif // BTSTACK_CONFIG_H
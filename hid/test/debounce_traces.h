@@ -0,0 +1,42 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DEBOUNCE_TRACES_H
+#define DEBOUNCE_TRACES_H
+
+// Button traces, one character per sample at DEBOUNCE_SAMPLE_US = 1 ms: '1' = pressed (pin low).
+// The traces are synthetic, hand-written after typical tactile switch bounce: a few ms of chatter
+// on press, shorter chatter on release, and single-sample glitches. Recorded captures can be added
+// later in the same format, test_debounce derives the expected edges from the trace itself.
+
+typedef struct {
+    const char * name;
+    const char * samples;
+    int          num_edges;     // expected debounced press + release edges
+} debounce_trace_t;
+
+static const debounce_trace_t debounce_traces[] = {
+    { "clean_tap",
+      "0000000000" "111111111111111111111111111111" "000000000000000000000000000000", 2 },
+    { "press_bounce",
+      "00000" "1010011011" "111111111111111111111111111111" "00000000000000000000", 2 },
+    { "release_bounce",
+      "000" "111111111111111111111111111111" "01011001010" "00000000000000000000", 2 },
+    { "press_and_release_bounce",
+      "0000" "1100101101110" "1111111111111111111111111" "0010110100" "000000000000000000000", 2 },
+    { "glitch_while_idle",
+      "0000000000" "11" "0000000000" "1" "000000000000000000000" "1111" "0000000000", 0 },
+    { "glitch_while_held",
+      "00000" "11111111111111111111" "00" "11111111111111111111" "0" "1111111111" "00000000000000000000", 2 },
+    { "rapid_taps",
+      "11111111111111111111" "00000000000000000000" "11111111111111111111" "00000000000000000000"
+      "11111111111111111111" "00000000000000000000" "11111111111111111111" "00000000000000000000"
+      "11111111111111111111" "00000000000000000000", 10 },
+    { "long_bounce",
+      "00000" "110111011101111" "11111111111111111111" "0001000100010001" "00000000000000000000", 2 },
+};
+
+#define DEBOUNCE_NUM_TRACES (sizeof(debounce_traces) / sizeof(debounce_traces[0]))
+
+#endif // DEBOUNCE_TRACES_H
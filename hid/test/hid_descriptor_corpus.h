@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HID_DESCRIPTOR_CORPUS_H
+#define HID_DESCRIPTOR_CORPUS_H
+
+#include <stdint.h>
+
+// Report descriptors for the report plan tests and benchmark: the descriptors of this repo,
+// plus keyboard, mouse and gamepad layouts as common devices use them.
+
+// repo keyboard with all options: 6KRO, NKRO bitmap, mouse and consumer control, each with a report ID
+#define ENABLE_NKRO_REPORT
+#define ENABLE_COMPOSITE
+#include "hid_descriptor_keyboard.h"
+
+#define ENABLE_MOUSE_16BIT
+#include "hid_descriptor_mouse.h"
+
+// USB HID Specification 1.11, Appendix B.1, without report ID
+static const uint8_t corpus_boot_keyboard[] = {
+    0x05, 0x01, 0x09, 0x06, 0xa1, 0x01,
+    0x05, 0x07, 0x19, 0xe0, 0x29, 0xe7, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02,   // modifiers
+    0x95, 0x01, 0x75, 0x08, 0x81, 0x01,                                                             // reserved
+    0x95, 0x05, 0x75, 0x01, 0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x91, 0x02,                         // LEDs
+    0x95, 0x01, 0x75, 0x03, 0x91, 0x01,
+    0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x25, 0x65, 0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00, // keys
+    0xc0,
+};
+
+// mouse as sold by most vendors: 5 buttons, 12-bit X/Y, wheel, and AC Pan in a second report
+static const uint8_t corpus_wheel_mouse[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01,
+    0x85, 0x02, 0x09, 0x01, 0xa1, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x05, 0x15, 0x00, 0x25, 0x01, 0x95, 0x05, 0x75, 0x01, 0x81, 0x02, // buttons
+    0x95, 0x01, 0x75, 0x03, 0x81, 0x01,
+    0x05, 0x01, 0x16, 0x01, 0xf8, 0x26, 0xff, 0x07, 0x75, 0x0c, 0x95, 0x02, 0x09, 0x30, 0x09, 0x31, 0x81, 0x06, // X, Y
+    0x15, 0x81, 0x25, 0x7f, 0x75, 0x08, 0x95, 0x01, 0x09, 0x38, 0x81, 0x06,                         // wheel
+    0xc0,
+    0x85, 0x03, 0x05, 0x0c, 0x0a, 0x38, 0x02, 0x15, 0x81, 0x25, 0x7f, 0x75, 0x08, 0x95, 0x01, 0x81, 0x06, // AC Pan
+    0xc0,
+};
+
+// gamepad: 4 axes, 2 triggers, hat switch with null state, 14 buttons, in Push/Pop blocks
+static const uint8_t corpus_gamepad[] = {
+    0x05, 0x01, 0x09, 0x05, 0xa1, 0x01,
+    0x85, 0x01,
+    0x09, 0x01, 0xa1, 0x00,
+    0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x15, 0x00, 0x26, 0xff, 0x00, 0x75, 0x08, 0x95, 0x04, 0x81, 0x02, // X Y Z Rz
+    0xc0,
+    0xa4,                                                                                           // push
+    0x05, 0x02, 0x09, 0xc5, 0x09, 0xc4, 0x15, 0x00, 0x26, 0xff, 0x03, 0x75, 0x0a, 0x95, 0x02, 0x81, 0x02, // brake, accelerator
+    0xb4,                                                                                           // pop
+    0x75, 0x04, 0x95, 0x01, 0x81, 0x03,
+    0x09, 0x39, 0x15, 0x00, 0x25, 0x07, 0x35, 0x00, 0x46, 0x3b, 0x01, 0x65, 0x14, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42, // hat
+    0x65, 0x00, 0x75, 0x04, 0x95, 0x01, 0x81, 0x03,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x0e, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x0e, 0x81, 0x02, // buttons
+    0x75, 0x02, 0x95, 0x01, 0x81, 0x03,
+    0xc0,
+};
+
+typedef struct {
+    const char *    name;
+    const uint8_t * descriptor;
+    uint16_t        descriptor_len;
+    uint8_t         num_reports;
+    uint8_t         report_ids[4];      // 0 if the descriptor doesn't use report IDs
+    uint8_t         report_lens[4];     // including report ID
+} hid_descriptor_corpus_entry_t;
+
+static const hid_descriptor_corpus_entry_t hid_descriptor_corpus[] = {
+    { "boot keyboard",    corpus_boot_keyboard,            sizeof(corpus_boot_keyboard),            1, { 0 },          { 8 } },
+    { "repo keyboard",    hid_descriptor_keyboard,         sizeof(hid_descriptor_keyboard),         4, { 1, 2, 3, 4 }, { 9, 15, 4, 3 } },
+    { "boot mouse",       hid_descriptor_mouse_boot_mode,  sizeof(hid_descriptor_mouse_boot_mode),  1, { 0 },          { 3 } },
+    { "16-bit mouse",     hid_descriptor_mouse_16bit,      sizeof(hid_descriptor_mouse_16bit),      1, { 0 },          { 5 } },
+    { "wheel mouse",      corpus_wheel_mouse,              sizeof(corpus_wheel_mouse),              2, { 2, 3 },       { 6, 2 } },
+    { "gamepad",          corpus_gamepad,                  sizeof(corpus_gamepad),                  1, { 1 },          { 11 } },
+};
+
+#define HID_DESCRIPTOR_CORPUS_SIZE (sizeof(hid_descriptor_corpus) / sizeof(hid_descriptor_corpus[0]))
+
+#endif // HID_DESCRIPTOR_CORPUS_H
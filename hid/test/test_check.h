@@ -0,0 +1,47 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+#include <time.h>
+
+// Minimal checks for the host tests, a test returns test_failures from main
+
+static int test_failures;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define CHECK_EQUAL(expected, actual) do { \
+    long long check_expected = (long long) (expected); \
+    long long check_actual   = (long long) (actual); \
+    if (check_expected != check_actual) { \
+        printf("%s:%d: CHECK_EQUAL(%s, %s) failed, expected %lld, got %lld\n", __FILE__, __LINE__, #expected, #actual, check_expected, check_actual); \
+        test_failures++; \
+    } \
+} while (0)
+
+static inline int test_result(const char * name){
+    if (test_failures){
+        printf("%s: %d check(s) failed\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+// monotonic time for the benchmarks
+static inline double test_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+#endif // TEST_CHECK_H
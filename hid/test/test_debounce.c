@@ -0,0 +1,151 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Replay bounce traces through the debouncer and check the debounced edges and their timing
+
+#include <string.h>
+
+#include "test_check.h"
+#include "debounce.h"
+#include "debounce_traces.h"
+
+// same as the keyboard demo: 1 ms sampling, edge accepted after 5 stable samples
+#define DEBOUNCE_SAMPLES 5
+
+#define MAX_EDGES 32
+
+typedef struct {
+    int  sample;        // debounced: sample that reported the edge, expected: first sample of the stable level
+    bool pressed;
+} edge_t;
+
+// expected edges: the level changes between runs that are stable for at least DEBOUNCE_SAMPLES samples
+static int trace_expected_edges(const char * samples, edge_t * edges){
+    int len = (int) strlen(samples);
+    char level = '0';
+    int num_edges = 0;
+    int start = 0;
+    while (start < len){
+        int end = start;
+        while ((end < len) && (samples[end] == samples[start])) end++;
+        if (((end - start) >= DEBOUNCE_SAMPLES) && (samples[start] != level)){
+            level = samples[start];
+            edges[num_edges].sample  = start;
+            edges[num_edges].pressed = level == '1';
+            num_edges++;
+        }
+        start = end;
+    }
+    return num_edges;
+}
+
+static int trace_sample(const char * samples, int sample){
+    int len = (int) strlen(samples);
+    if (sample >= len) sample = len - 1;
+    return samples[sample] == '1';
+}
+
+static int trace_max_len(void){
+    int max_len = 0;
+    unsigned int i;
+    for (i = 0; i < DEBOUNCE_NUM_TRACES; i++){
+        int len = (int) strlen(debounce_traces[i].samples);
+        if (len > max_len) max_len = len;
+    }
+    return max_len;
+}
+
+// replay all traces at once, trace i on input bit i, and collect the debounced edges per trace
+static void replay(uint32_t mask, edge_t edges[][MAX_EDGES], int * num_edges){
+    debounce_t debounce;
+    debounce_init(&debounce, mask, DEBOUNCE_SAMPLES);
+    int num_samples = trace_max_len();
+    int sample;
+    for (sample = 0; sample < num_samples; sample++){
+        uint32_t active = 0;
+        unsigned int i;
+        for (i = 0; i < DEBOUNCE_NUM_TRACES; i++){
+            if (trace_sample(debounce_traces[i].samples, sample)){
+                active |= 1u << i;
+            }
+        }
+        uint32_t changed = debounce_update(&debounce, active);
+        CHECK_EQUAL(0, changed & ~mask);
+        for (i = 0; i < DEBOUNCE_NUM_TRACES; i++){
+            if ((changed & (1u << i)) == 0) continue;
+            if (num_edges[i] == MAX_EDGES) continue;
+            edges[i][num_edges[i]].sample  = sample;
+            edges[i][num_edges[i]].pressed = (debounce_get_state(&debounce) & (1u << i)) != 0;
+            num_edges[i]++;
+        }
+    }
+}
+
+static void test_traces(void){
+    edge_t edges[DEBOUNCE_NUM_TRACES][MAX_EDGES];
+    int num_edges[DEBOUNCE_NUM_TRACES];
+    memset(num_edges, 0, sizeof(num_edges));
+    replay((1u << DEBOUNCE_NUM_TRACES) - 1, edges, num_edges);
+
+    unsigned int i;
+    for (i = 0; i < DEBOUNCE_NUM_TRACES; i++){
+        const debounce_trace_t * trace = &debounce_traces[i];
+        edge_t expected[MAX_EDGES];
+        int num_expected = trace_expected_edges(trace->samples, expected);
+        if ((num_expected != trace->num_edges) || (num_edges[i] != trace->num_edges)){
+            printf("%s: %d edges expected, %d in trace, %d debounced\n", trace->name, trace->num_edges, num_expected, num_edges[i]);
+            test_failures++;
+            continue;
+        }
+        int e;
+        for (e = 0; e < num_expected; e++){
+            CHECK_EQUAL(expected[e].pressed, edges[i][e].pressed);
+            // reported within DEBOUNCE_SAMPLES samples of the level becoming stable
+            if (edges[i][e].sample > expected[e].sample + DEBOUNCE_SAMPLES - 1){
+                printf("%s: edge %d at %d ms, stable since %d ms\n", trace->name, e, edges[i][e].sample, expected[e].sample);
+                test_failures++;
+            }
+            // and not before the previous level was stable
+            if ((e > 0) && (edges[i][e].sample < expected[e - 1].sample + DEBOUNCE_SAMPLES - 1)){
+                printf("%s: edge %d at %d ms, before previous level settled\n", trace->name, e, edges[i][e].sample);
+                test_failures++;
+            }
+        }
+    }
+}
+
+// a clean edge is reported exactly DEBOUNCE_SAMPLES samples after it
+static void test_clean_edge_latency(void){
+    debounce_t debounce;
+    debounce_init(&debounce, 0x01, DEBOUNCE_SAMPLES);
+    int sample;
+    for (sample = 0; sample < DEBOUNCE_SAMPLES - 1; sample++){
+        CHECK_EQUAL(0, debounce_update(&debounce, 0x01));
+    }
+    CHECK_EQUAL(0x01, debounce_update(&debounce, 0x01));
+    CHECK_EQUAL(0x01, debounce_get_state(&debounce));
+    for (sample = 0; sample < DEBOUNCE_SAMPLES - 1; sample++){
+        CHECK_EQUAL(0, debounce_update(&debounce, 0x00));
+    }
+    CHECK_EQUAL(0x01, debounce_update(&debounce, 0x00));
+    CHECK_EQUAL(0x00, debounce_get_state(&debounce));
+}
+
+// inputs outside the mask never change
+static void test_mask(void){
+    debounce_t debounce;
+    debounce_init(&debounce, 0x0f, DEBOUNCE_SAMPLES);
+    int sample;
+    for (sample = 0; sample < 2 * DEBOUNCE_SAMPLES; sample++){
+        debounce_update(&debounce, 0xffffffff);
+    }
+    CHECK_EQUAL(0x0f, debounce_get_state(&debounce));
+}
+
+int main(void){
+    test_traces();
+    test_clean_edge_latency();
+    test_mask();
+    return test_result("test_debounce");
+}
@@ -0,0 +1,287 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Report plan decoding over the descriptor corpus: fixed reports against hand-decoded fields,
+// and, if BTstack is available, random reports against btstack_hid_parser
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_check.h"
+#include "hid_descriptor_corpus.h"
+#include "hid_report_plan.h"
+
+#ifdef HAVE_BTSTACK_HID_PARSER
+#include "btstack_hid_parser.h"
+#endif
+
+#define MAX_DECODED_FIELDS 128
+#define RANDOM_REPORTS     2000
+
+typedef struct {
+    uint16_t usage_page;
+    uint16_t usage;
+    int32_t  value;
+} decoded_field_t;
+
+static const hid_descriptor_corpus_entry_t * corpus_entry(const char * name){
+    unsigned int i;
+    for (i = 0; i < HID_DESCRIPTOR_CORPUS_SIZE; i++){
+        if (strcmp(hid_descriptor_corpus[i].name, name) == 0) return &hid_descriptor_corpus[i];
+    }
+    return NULL;
+}
+
+static int plan_decode(const hid_report_plan_t * plan, const uint8_t * report, uint16_t report_len, decoded_field_t * fields){
+    hid_report_plan_iterator_t iterator;
+    hid_report_plan_iterator_init(&iterator, plan, report, report_len);
+    int num_fields = 0;
+    while (hid_report_plan_iterator_has_more(&iterator) && (num_fields < MAX_DECODED_FIELDS)){
+        decoded_field_t * field = &fields[num_fields++];
+        hid_report_plan_iterator_get_field(&iterator, &field->usage_page, &field->usage, &field->value);
+    }
+    return num_fields;
+}
+
+static void check_fields(const char * name, const decoded_field_t * expected, int num_expected,
+                         const decoded_field_t * actual, int num_actual){
+    int i;
+    for (i = 0; (i < num_expected) || (i < num_actual); i++){
+        if ((i < num_expected) && (i < num_actual) && (memcmp(&expected[i], &actual[i], sizeof(decoded_field_t)) == 0)) continue;
+        printf("%s: field %d: expected ", name, i);
+        if (i < num_expected){
+            printf("%04x/%04x=%d", expected[i].usage_page, expected[i].usage, (int) expected[i].value);
+        } else {
+            printf("none");
+        }
+        printf(", got ");
+        if (i < num_actual){
+            printf("%04x/%04x=%d\n", actual[i].usage_page, actual[i].usage, (int) actual[i].value);
+        } else {
+            printf("none\n");
+        }
+        test_failures++;
+        return;
+    }
+}
+
+// decode report with the plan of corpus entry and check all fields
+static void check_report(const char * entry_name, const uint8_t * report, uint16_t report_len,
+                         const decoded_field_t * expected, int num_expected){
+    const hid_descriptor_corpus_entry_t * entry = corpus_entry(entry_name);
+    CHECK(entry != NULL);
+    if (entry == NULL) return;
+    hid_report_plan_t plan;
+    CHECK(hid_report_plan_compile(&plan, entry->descriptor, entry->descriptor_len));
+    decoded_field_t actual[MAX_DECODED_FIELDS];
+    int num_actual = plan_decode(&plan, report, report_len, actual);
+    check_fields(entry_name, expected, num_expected, actual, num_actual);
+}
+
+#define NUM(fields) ((int) (sizeof(fields) / sizeof(fields[0])))
+
+static void test_boot_keyboard(void){
+    // Left Shift + 'a' 'b', empty slots are skipped
+    static const uint8_t report[] = { 0x02, 0x00, 0x04, 0x05, 0x00, 0x00, 0x00, 0x00 };
+    static const decoded_field_t expected[] = {
+        { 0x07, 0xe0, 0 }, { 0x07, 0xe1, 1 }, { 0x07, 0xe2, 0 }, { 0x07, 0xe3, 0 },
+        { 0x07, 0xe4, 0 }, { 0x07, 0xe5, 0 }, { 0x07, 0xe6, 0 }, { 0x07, 0xe7, 0 },
+        { 0x07, 0x04, 1 }, { 0x07, 0x05, 1 },
+    };
+    check_report("boot keyboard", report, sizeof(report), expected, NUM(expected));
+
+    // report shorter than described: slots outside are skipped
+    static const decoded_field_t expected_short[] = {
+        { 0x07, 0xe0, 0 }, { 0x07, 0xe1, 1 }, { 0x07, 0xe2, 0 }, { 0x07, 0xe3, 0 },
+        { 0x07, 0xe4, 0 }, { 0x07, 0xe5, 0 }, { 0x07, 0xe6, 0 }, { 0x07, 0xe7, 0 },
+        { 0x07, 0x04, 1 },
+    };
+    check_report("boot keyboard", report, 3, expected_short, NUM(expected_short));
+
+    // key outside logical range (0x65) is not reported
+    static const uint8_t report_out_of_range[] = { 0x00, 0x00, 0x66, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    static const decoded_field_t expected_out_of_range[] = {
+        { 0x07, 0xe0, 0 }, { 0x07, 0xe1, 0 }, { 0x07, 0xe2, 0 }, { 0x07, 0xe3, 0 },
+        { 0x07, 0xe4, 0 }, { 0x07, 0xe5, 0 }, { 0x07, 0xe6, 0 }, { 0x07, 0xe7, 0 },
+    };
+    check_report("boot keyboard", report_out_of_range, sizeof(report_out_of_range), expected_out_of_range, NUM(expected_out_of_range));
+}
+
+static void test_repo_keyboard(void){
+    // composite mouse report: buttons 1 and 3, X -1, Y 16
+    static const uint8_t mouse_report[] = { REPORT_ID_MOUSE, 0x05, 0xff, 0x10 };
+    static const decoded_field_t mouse_expected[] = {
+        { 0x09, 0x01, 1 }, { 0x09, 0x02, 0 }, { 0x09, 0x03, 1 }, { 0x01, 0x30, -1 }, { 0x01, 0x31, 16 },
+    };
+    check_report("repo keyboard", mouse_report, sizeof(mouse_report), mouse_expected, NUM(mouse_expected));
+
+    // consumer control: Play/Pause, then released
+    static const uint8_t consumer_report[] = { REPORT_ID_CONSUMER, 0xcd, 0x00 };
+    static const decoded_field_t consumer_expected[] = { { 0x0c, 0xcd, 1 } };
+    check_report("repo keyboard", consumer_report, sizeof(consumer_report), consumer_expected, NUM(consumer_expected));
+    static const uint8_t consumer_released[] = { REPORT_ID_CONSUMER, 0x00, 0x00 };
+    check_report("repo keyboard", consumer_released, sizeof(consumer_released), NULL, 0);
+
+    // NKRO bitmap: every usage 0x00..0x67 is reported, 'a' (0x04) and Keypad = (0x67) held
+    static const uint8_t nkro_report[] = { REPORT_ID_NKRO, 0x00, 0x10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x80 };
+    decoded_field_t nkro_expected[8 + NKRO_NUM_KEYCODES];
+    int i;
+    for (i = 0; i < 8; i++){
+        nkro_expected[i] = (decoded_field_t) { 0x07, (uint16_t) (0xe0 + i), 0 };
+    }
+    for (i = 0; i < NKRO_NUM_KEYCODES; i++){
+        nkro_expected[8 + i] = (decoded_field_t) { 0x07, (uint16_t) i, (i == 0x04) || (i == 0x67) };
+    }
+    check_report("repo keyboard", nkro_report, sizeof(nkro_report), nkro_expected, NUM(nkro_expected));
+
+    // unknown report ID
+    static const uint8_t unknown_report[] = { 0x09, 0xff, 0xff };
+    check_report("repo keyboard", unknown_report, sizeof(unknown_report), NULL, 0);
+}
+
+static void test_mice(void){
+    // 16-bit mouse: X -300, Y 1000
+    static const uint8_t report_16bit[] = { 0x02, 0xd4, 0xfe, 0xe8, 0x03 };
+    static const decoded_field_t expected_16bit[] = {
+        { 0x09, 0x01, 0 }, { 0x09, 0x02, 1 }, { 0x09, 0x03, 0 }, { 0x01, 0x30, -300 }, { 0x01, 0x31, 1000 },
+    };
+    check_report("16-bit mouse", report_16bit, sizeof(report_16bit), expected_16bit, NUM(expected_16bit));
+
+    // wheel mouse: button 5, X -2047, Y 2047 in 12 bits each, wheel -1
+    static const uint8_t report_wheel[] = { 0x02, 0x10, 0x01, 0xf8, 0x7f, 0xff };
+    static const decoded_field_t expected_wheel[] = {
+        { 0x09, 0x01, 0 }, { 0x09, 0x02, 0 }, { 0x09, 0x03, 0 }, { 0x09, 0x04, 0 }, { 0x09, 0x05, 1 },
+        { 0x01, 0x30, -2047 }, { 0x01, 0x31, 2047 }, { 0x01, 0x38, -1 },
+    };
+    check_report("wheel mouse", report_wheel, sizeof(report_wheel), expected_wheel, NUM(expected_wheel));
+
+    static const uint8_t report_pan[] = { 0x03, 0x02 };
+    static const decoded_field_t expected_pan[] = { { 0x0c, 0x238, 2 } };
+    check_report("wheel mouse", report_pan, sizeof(report_pan), expected_pan, NUM(expected_pan));
+}
+
+static void test_gamepad(void){
+    // axes, brake 0x3ff, accelerator 0x155, hat in null state (8), buttons 1 and 14
+    static const uint8_t report[] = { 0x01, 0x00, 0x80, 0xff, 0x7f, 0xff, 0x57, 0x05, 0x08, 0x01, 0x20 };
+    decoded_field_t expected[4 + 2 + 1 + 14] = {
+        { 0x01, 0x30, 0x00 }, { 0x01, 0x31, 0x80 }, { 0x01, 0x32, 0xff }, { 0x01, 0x35, 0x7f },
+        { 0x02, 0xc5, 0x3ff }, { 0x02, 0xc4, 0x155 },
+        { 0x01, 0x39, 8 },
+    };
+    int i;
+    for (i = 0; i < 14; i++){
+        expected[7 + i] = (decoded_field_t) { 0x09, (uint16_t) (1 + i), (i == 0) || (i == 13) };
+    }
+    check_report("gamepad", report, sizeof(report), expected, NUM(expected));
+}
+
+static void test_malformed(void){
+    hid_report_plan_t plan;
+    // item data beyond descriptor end
+    static const uint8_t truncated[] = { 0x05, 0x01, 0x26, 0xff };
+    CHECK(hid_report_plan_compile(&plan, truncated, sizeof(truncated)) == false);
+    // pop without push
+    static const uint8_t pop[] = { 0x05, 0x01, 0xb4 };
+    CHECK(hid_report_plan_compile(&plan, pop, sizeof(pop)) == false);
+    // report ID 0 is reserved
+    static const uint8_t report_id_0[] = { 0x85, 0x00 };
+    CHECK(hid_report_plan_compile(&plan, report_id_0, sizeof(report_id_0)) == false);
+}
+
+#ifdef HAVE_BTSTACK_HID_PARSER
+
+static int parser_decode(const uint8_t * descriptor, uint16_t descriptor_len, const uint8_t * report, uint16_t report_len,
+                         decoded_field_t * fields){
+    btstack_hid_parser_t parser;
+    btstack_hid_parser_init(&parser, descriptor, descriptor_len, HID_REPORT_TYPE_INPUT, report, report_len);
+    int num_fields = 0;
+    while (btstack_hid_parser_has_more(&parser) && (num_fields < MAX_DECODED_FIELDS)){
+        decoded_field_t * field = &fields[num_fields];
+        btstack_hid_parser_get_field(&parser, &field->usage_page, &field->usage, &field->value);
+        // empty array slots and padding without usage carry no input, the plan skips them
+        if (field->usage == 0) continue;
+        num_fields++;
+    }
+    return num_fields;
+}
+
+static int drop_usage_0(decoded_field_t * fields, int num_fields){
+    int count = 0;
+    int i;
+    for (i = 0; i < num_fields; i++){
+        if (fields[i].usage == 0) continue;
+        fields[count++] = fields[i];
+    }
+    return count;
+}
+
+// random content, with array slots inside their logical range as devices send them
+static void random_report(const hid_report_plan_t * plan, uint8_t report_id, uint8_t * report, uint16_t report_len){
+    uint16_t i;
+    for (i = 0; i < report_len; i++){
+        report[i] = (uint8_t) rand();
+    }
+    uint8_t * data = report;
+    if (plan->has_report_ids){
+        report[0] = report_id;
+        data++;
+    }
+    for (i = 0; i < plan->num_fields; i++){
+        const hid_report_field_t * field = &plan->fields[i];
+        if ((field->flags & HID_REPORT_FIELD_ARRAY) == 0) continue;
+        uint16_t slot;
+        for (slot = 0; slot < field->count; slot++){
+            uint32_t range = (uint32_t) (field->logical_max - field->logical_min) + 1;
+            uint32_t value = (uint32_t) field->logical_min + (uint32_t) rand() % range;
+            uint32_t bit_offset = field->bit_offset + (uint32_t) slot * field->bit_size;
+            uint8_t bit;
+            for (bit = 0; bit < field->bit_size; bit++){
+                uint32_t pos = bit_offset + bit;
+                if ((pos >> 3) >= (uint32_t) (report_len - (data - report))) break;
+                data[pos >> 3] = (uint8_t) ((data[pos >> 3] & ~(1u << (pos & 7))) | (((value >> bit) & 1u) << (pos & 7)));
+            }
+        }
+    }
+}
+
+static void test_against_btstack_hid_parser(void){
+    srand(1);
+    unsigned int e;
+    for (e = 0; e < HID_DESCRIPTOR_CORPUS_SIZE; e++){
+        const hid_descriptor_corpus_entry_t * entry = &hid_descriptor_corpus[e];
+        hid_report_plan_t plan;
+        CHECK(hid_report_plan_compile(&plan, entry->descriptor, entry->descriptor_len));
+        uint8_t r;
+        for (r = 0; r < entry->num_reports; r++){
+            int n;
+            for (n = 0; n < RANDOM_REPORTS; n++){
+                uint8_t report[64];
+                random_report(&plan, entry->report_ids[r], report, entry->report_lens[r]);
+                decoded_field_t expected[MAX_DECODED_FIELDS];
+                decoded_field_t actual[MAX_DECODED_FIELDS];
+                int num_expected = parser_decode(entry->descriptor, entry->descriptor_len, report, entry->report_lens[r], expected);
+                int num_actual = drop_usage_0(actual, plan_decode(&plan, report, entry->report_lens[r], actual));
+                int failures = test_failures;
+                check_fields(entry->name, expected, num_expected, actual, num_actual);
+                // one report per entry is enough to show the difference
+                if (test_failures != failures) break;
+            }
+        }
+    }
+}
+#endif
+
+int main(void){
+    test_boot_keyboard();
+    test_repo_keyboard();
+    test_mice();
+    test_gamepad();
+    test_malformed();
+#ifdef HAVE_BTSTACK_HID_PARSER
+    test_against_btstack_hid_parser();
+#else
+    printf("btstack_hid_parser not found, comparison skipped. Set BTSTACK_ROOT to run it\n");
+#endif
+    return test_result("test_hid_report_plan");
+}
@@ -0,0 +1,70 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// key_latency: stage samples, and the total measured from the oldest key event a report carries
+
+#include "test_check.h"
+#include "key_latency.h"
+
+static uint32_t stage_count(const key_latency_t * latency, key_latency_stage_t stage){
+    return latency_histogram_get_count(key_latency_get_histogram(latency, stage));
+}
+
+static uint32_t stage_max(const key_latency_t * latency, key_latency_stage_t stage){
+    return latency_histogram_get_max(key_latency_get_histogram(latency, stage));
+}
+
+static void test_single_key(void){
+    key_latency_t latency;
+    key_latency_init(&latency);
+    key_latency_key_event(&latency, 1000, 1100);
+    key_latency_report_requested(&latency, 1100);
+    key_latency_can_send_now(&latency, 4100);
+    key_latency_report_sent(&latency, 4150);
+    CHECK_EQUAL(100, stage_max(&latency, KEY_LATENCY_STAGE_QUEUE));
+    CHECK_EQUAL(3000, stage_max(&latency, KEY_LATENCY_STAGE_CAN_SEND_NOW));
+    CHECK_EQUAL(3150, stage_max(&latency, KEY_LATENCY_STAGE_TOTAL));
+}
+
+// two key events merged into one report: one total sample, from the first key event
+static void test_coalesced(void){
+    key_latency_t latency;
+    key_latency_init(&latency);
+    key_latency_key_event(&latency, 1000, 1010);
+    key_latency_report_requested(&latency, 1010);
+    key_latency_key_event(&latency, 2000, 2010);
+    key_latency_can_send_now(&latency, 5000);
+    key_latency_report_sent(&latency, 5000);
+    CHECK_EQUAL(2, stage_count(&latency, KEY_LATENCY_STAGE_QUEUE));
+    CHECK_EQUAL(1, stage_count(&latency, KEY_LATENCY_STAGE_TOTAL));
+    CHECK_EQUAL(4000, stage_max(&latency, KEY_LATENCY_STAGE_TOTAL));
+}
+
+// reports without key input, e.g. typed text, don't add to the total
+static void test_report_without_key(void){
+    key_latency_t latency;
+    key_latency_init(&latency);
+    key_latency_report_requested(&latency, 0);
+    key_latency_can_send_now(&latency, 500);
+    key_latency_report_sent(&latency, 500);
+    CHECK_EQUAL(1, stage_count(&latency, KEY_LATENCY_STAGE_CAN_SEND_NOW));
+    CHECK_EQUAL(0, stage_count(&latency, KEY_LATENCY_STAGE_TOTAL));
+}
+
+// time_us_32() wraps after 71 minutes
+static void test_wrap(void){
+    key_latency_t latency;
+    key_latency_init(&latency);
+    key_latency_key_event(&latency, 0xffffff00, 0xffffff80);
+    key_latency_report_sent(&latency, 0x00000100);
+    CHECK_EQUAL(0x200, stage_max(&latency, KEY_LATENCY_STAGE_TOTAL));
+}
+
+int main(void){
+    test_single_key();
+    test_coalesced();
+    test_report_without_key();
+    test_wrap();
+    return test_result("test_key_latency");
+}
@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Key matrix debouncing, ghost handling and diffing
+
+#include <string.h>
+
+#include "test_check.h"
+#include "key_matrix.h"
+
+// same as the keyboard demo
+#define MATRIX_ROWS      9
+#define MATRIX_COLS      7
+#define DEBOUNCE_SAMPLES 5
+
+#define MAX_EVENTS 32
+
+typedef struct {
+    uint8_t row;
+    uint8_t col;
+    bool    pressed;
+} event_t;
+
+static event_t events[MAX_EVENTS];
+static int     num_events;
+static int     num_callbacks;
+
+static void record_event(uint8_t row, uint8_t col, bool pressed, void * context){
+    (void) context;
+    num_callbacks++;
+    if (num_events == MAX_EVENTS) return;
+    events[num_events].row = row;
+    events[num_events].col = col;
+    events[num_events].pressed = pressed;
+    num_events++;
+}
+
+static void events_clear(void){
+    num_events = 0;
+    num_callbacks = 0;
+}
+
+static void check_event(int index, uint8_t row, uint8_t col, bool pressed){
+    CHECK(index < num_events);
+    if (index >= num_events) return;
+    CHECK_EQUAL(row, events[index].row);
+    CHECK_EQUAL(col, events[index].col);
+    CHECK_EQUAL(pressed, events[index].pressed);
+}
+
+// feed the same snapshot until it is debounced, returns the ghost result of the last update
+static bool settle(key_matrix_t * matrix, const uint32_t * snapshot){
+    bool ghost = false;
+    int i;
+    for (i = 0; i < DEBOUNCE_SAMPLES; i++){
+        ghost = key_matrix_update(matrix, snapshot, &record_event, NULL);
+    }
+    return ghost;
+}
+
+static void test_debounce_in_row(void){
+    key_matrix_t matrix;
+    key_matrix_init(&matrix, MATRIX_ROWS, MATRIX_COLS, DEBOUNCE_SAMPLES);
+    uint32_t snapshot[MATRIX_ROWS];
+    memset(snapshot, 0, sizeof(snapshot));
+    events_clear();
+
+    // column 3 of row 2 bounces, column 5 of the same row is pressed cleanly at the same time
+    static const uint8_t bounce[] = { 1, 0, 1, 1, 0, 1, 0, 0, 1, 1, 1, 1, 1 };
+    unsigned int i;
+    for (i = 0; i < sizeof(bounce); i++){
+        snapshot[2] = (1u << 5) | (bounce[i] ? (1u << 3) : 0);
+        key_matrix_update(&matrix, snapshot, &record_event, NULL);
+        if (i == DEBOUNCE_SAMPLES - 1){
+            // clean key is reported after DEBOUNCE_SAMPLES samples, the bouncing one is not yet
+            CHECK_EQUAL(1, num_events);
+            check_event(0, 2, 5, true);
+        }
+    }
+    // bouncing key only once it was stable for DEBOUNCE_SAMPLES samples
+    CHECK_EQUAL(2, num_events);
+    check_event(1, 2, 3, true);
+
+    // single sample glitch on release is filtered
+    events_clear();
+    snapshot[2] = 1u << 5;
+    key_matrix_update(&matrix, snapshot, &record_event, NULL);
+    snapshot[2] = (1u << 5) | (1u << 3);
+    settle(&matrix, snapshot);
+    CHECK_EQUAL(0, num_events);
+
+    // release
+    snapshot[2] = 0;
+    settle(&matrix, snapshot);
+    CHECK_EQUAL(2, num_events);
+    check_event(0, 2, 3, false);
+    check_event(1, 2, 5, false);
+}
+
+static void test_ghost_rows_accept_releases_only(void){
+    key_matrix_t matrix;
+    key_matrix_init(&matrix, MATRIX_ROWS, MATRIX_COLS, DEBOUNCE_SAMPLES);
+    uint32_t snapshot[MATRIX_ROWS];
+    memset(snapshot, 0, sizeof(snapshot));
+    events_clear();
+
+    // row 0: columns 0, 1, 2 held
+    snapshot[0] = 0x07;
+    CHECK(settle(&matrix, snapshot) == false);
+    CHECK_EQUAL(3, num_events);
+
+    // pressing (1, 0) also makes (1, 1) read pressed: rows 0 and 1 share two columns
+    events_clear();
+    snapshot[1] = 0x03;
+    CHECK(settle(&matrix, snapshot) == true);
+    CHECK_EQUAL(0, num_events);
+    CHECK_EQUAL(0x00, matrix.state[1]);
+
+    // releasing (0, 2) while ghosting is accepted, rows 0 and 1 still share two columns
+    snapshot[0] = 0x03;
+    CHECK(settle(&matrix, snapshot) == true);
+    CHECK_EQUAL(1, num_events);
+    check_event(0, 0, 2, false);
+    CHECK_EQUAL(0x03, matrix.state[0]);
+    CHECK_EQUAL(0x00, matrix.state[1]);
+
+    // releasing (0, 1) resolves the rectangle: (1, 0) was real, the ghost (1, 1) is gone
+    events_clear();
+    snapshot[0] = 0x01;
+    snapshot[1] = 0x01;
+    CHECK(settle(&matrix, snapshot) == false);
+    CHECK_EQUAL(2, num_events);
+    check_event(0, 0, 1, false);
+    check_event(1, 1, 0, true);
+}
+
+static void test_fast_path(void){
+    key_matrix_t matrix;
+    key_matrix_init(&matrix, MATRIX_ROWS, MATRIX_COLS, DEBOUNCE_SAMPLES);
+    uint32_t snapshot[MATRIX_ROWS];
+    memset(snapshot, 0, sizeof(snapshot));
+    snapshot[4] = 0x11;
+    events_clear();
+    settle(&matrix, snapshot);
+    CHECK_EQUAL(2, num_events);
+
+    // unchanged snapshots: no callbacks, no ghosting, state untouched
+    uint32_t state[KEY_MATRIX_MAX_ROWS];
+    memcpy(state, matrix.state, sizeof(state));
+    events_clear();
+    int i;
+    for (i = 0; i < 100; i++){
+        CHECK(key_matrix_update(&matrix, snapshot, &record_event, NULL) == false);
+    }
+    CHECK_EQUAL(0, num_callbacks);
+    CHECK(memcmp(state, matrix.state, sizeof(state)) == 0);
+
+    // columns outside the matrix are ignored
+    snapshot[4] |= 1u << MATRIX_COLS;
+    settle(&matrix, snapshot);
+    CHECK_EQUAL(0, num_callbacks);
+}
+
+int main(void){
+    test_debounce_in_row();
+    test_ghost_rows_accept_releases_only();
+    test_fast_path();
+    return test_result("test_key_matrix");
+}
@@ -0,0 +1,110 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// key_state: modifiers, 6 key and NKRO layouts, rollover and reserved keycodes
+
+#include <string.h>
+
+#include "test_check.h"
+#include "key_state.h"
+
+#define NUM_KEYS 6
+#define NKRO_BITMAP_SIZE 29
+
+static void test_modifiers(void){
+    key_state_t state;
+    key_state_clear(&state);
+    key_state_press(&state, 0xe0);     // Left Ctrl
+    key_state_press(&state, 0xe7);     // Right GUI
+    uint8_t payload[2 + NUM_KEYS];
+    key_state_compose_keys(&state, payload, NUM_KEYS);
+    CHECK_EQUAL(0x81, payload[0]);
+    CHECK_EQUAL(0, payload[2]);
+    key_state_release(&state, 0xe0);
+    key_state_compose_keys(&state, payload, NUM_KEYS);
+    CHECK_EQUAL(0x80, payload[0]);
+}
+
+static void test_keys(void){
+    key_state_t state;
+    key_state_clear(&state);
+    key_state_press(&state, 0x16);     // s
+    key_state_press(&state, 0x04);     // a
+    key_state_press(&state, 0xe1);     // Left Shift
+    uint8_t payload[2 + NUM_KEYS];
+    memset(payload, 0xff, sizeof(payload));
+    key_state_compose_keys(&state, payload, NUM_KEYS);
+    static const uint8_t expected[] = { 0x02, 0x00, 0x04, 0x16, 0x00, 0x00, 0x00, 0x00 };
+    CHECK(memcmp(expected, payload, sizeof(expected)) == 0);
+
+    key_state_release(&state, 0x04);
+    key_state_compose_keys(&state, payload, NUM_KEYS);
+    CHECK_EQUAL(0x16, payload[2]);
+    CHECK_EQUAL(0x00, payload[3]);
+}
+
+static void test_rollover(void){
+    key_state_t state;
+    key_state_clear(&state);
+    uint8_t keycode;
+    for (keycode = 0x04; keycode < 0x04 + NUM_KEYS; keycode++){
+        key_state_press(&state, keycode);
+    }
+    uint8_t payload[2 + NUM_KEYS];
+    key_state_compose_keys(&state, payload, NUM_KEYS);
+    CHECK_EQUAL(0x04 + NUM_KEYS - 1, payload[2 + NUM_KEYS - 1]);
+
+    // one more: all slots ErrorRollOver, modifiers still reported
+    key_state_press(&state, 0x28);
+    key_state_press(&state, 0xe2);
+    key_state_compose_keys(&state, payload, NUM_KEYS);
+    CHECK_EQUAL(0x04, payload[0]);
+    int i;
+    for (i = 0; i < NUM_KEYS; i++){
+        CHECK_EQUAL(0x01, payload[2 + i]);
+    }
+
+    key_state_release(&state, 0x28);
+    key_state_compose_keys(&state, payload, NUM_KEYS);
+    CHECK_EQUAL(0x04, payload[2]);
+}
+
+static void test_bitmap(void){
+    key_state_t state;
+    key_state_clear(&state);
+    key_state_press(&state, 0x04);
+    key_state_press(&state, 0x0b);
+    key_state_press(&state, 0xe5);     // Right Shift
+    uint8_t payload[1 + NKRO_BITMAP_SIZE];
+    key_state_compose_bitmap(&state, payload, NKRO_BITMAP_SIZE);
+    CHECK_EQUAL(0x20, payload[0]);
+    CHECK_EQUAL(0x10, payload[1]);     // 0x04: byte 0, bit 4
+    CHECK_EQUAL(0x08, payload[2]);     // 0x0b: byte 1, bit 3
+    int i;
+    for (i = 3; i < 1 + NKRO_BITMAP_SIZE; i++){
+        CHECK_EQUAL(0, payload[i]);
+    }
+}
+
+// inputs taken from reserved keycodes, e.g. mouse or host switch buttons, are not keys
+static void test_reserved(void){
+    key_state_t state;
+    key_state_clear(&state);
+    key_state_press(&state, KEY_STATE_RESERVED_FIRST);
+    key_state_press(&state, 0xff);
+    key_state_t empty;
+    key_state_clear(&empty);
+    CHECK(memcmp(&empty, &state, sizeof(key_state_t)) == 0);
+    key_state_release(&state, 0xf0);
+    CHECK(memcmp(&empty, &state, sizeof(key_state_t)) == 0);
+}
+
+int main(void){
+    test_modifiers();
+    test_keys();
+    test_rollover();
+    test_bitmap();
+    test_reserved();
+    return test_result("test_key_state");
+}
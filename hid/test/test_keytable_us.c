@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// keytable_us must translate every character like the previous two-table scan
+
+#include "test_check.h"
+#include "keytable_us_scan.h"
+
+int main(void){
+    int character;
+    for (character = 0; character < 0xff; character++){
+        uint8_t scan_keycode = 0;
+        uint8_t scan_modifier = 0;
+        uint8_t keycode = 0;
+        uint8_t modifier = 0;
+        bool scan_found = keytable_us_scan((uint8_t) character, &scan_keycode, &scan_modifier);
+        bool found = keytable_us_lookup((uint8_t) character, &keycode, &modifier);
+        CHECK_EQUAL(scan_found, found);
+        if (scan_found && found){
+            CHECK_EQUAL(scan_keycode, keycode);
+            CHECK_EQUAL(scan_modifier, modifier);
+        }
+    }
+
+    // 0xff only matched the CHAR_ILLEGAL padding of the old tables, as keycode 0
+    uint8_t keycode;
+    uint8_t modifier;
+    CHECK(keytable_us_scan(0xff, &keycode, &modifier) && (keycode == 0));
+    CHECK(keytable_us_lookup(0xff, &keycode, &modifier) == false);
+
+    return test_result("test_keytable_us");
+}
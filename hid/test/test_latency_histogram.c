@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Latency histogram percentiles against exact percentiles of the same samples
+
+#include <stdlib.h>
+
+#include "test_check.h"
+#include "latency_histogram.h"
+
+#define NUM_SAMPLES 10000
+
+static int compare_uint32(const void * a, const void * b){
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+// exact percentile with the same rank definition as the histogram
+static uint32_t exact_percentile(const uint32_t * sorted, uint32_t count, uint32_t percent){
+    uint32_t rank = (uint32_t) (((uint64_t) count * percent + 99) / 100);
+    if (rank == 0){
+        rank = 1;
+    }
+    return sorted[rank - 1];
+}
+
+static void test_empty(void){
+    latency_histogram_t histogram;
+    latency_histogram_init(&histogram);
+    CHECK_EQUAL(0, latency_histogram_get_count(&histogram));
+    CHECK_EQUAL(0, latency_histogram_get_max(&histogram));
+    CHECK_EQUAL(0, latency_histogram_get_percentile(&histogram, 50));
+}
+
+// every value is reported within its bucket: not below, less than 25% above
+static void test_single_values(void){
+    uint32_t value;
+    for (value = 0; value < 100000; value += (value < 1000) ? 1 : 97){
+        latency_histogram_t histogram;
+        latency_histogram_init(&histogram);
+        latency_histogram_add(&histogram, value);
+        latency_histogram_add(&histogram, 0xffffffff);
+        uint32_t p50 = latency_histogram_get_percentile(&histogram, 50);
+        CHECK(p50 >= value);
+        CHECK((uint64_t) p50 * 4 <= (uint64_t) value * 5 + 3);
+    }
+}
+
+static void test_percentiles(void){
+    static uint32_t samples[NUM_SAMPLES];
+    latency_histogram_t histogram;
+    latency_histogram_init(&histogram);
+    srand(1);
+    int i;
+    for (i = 0; i < NUM_SAMPLES; i++){
+        // mostly a few ms, with a long tail
+        uint32_t latency_us = 500 + (uint32_t) (rand() % 5000);
+        if ((i % 100) == 0){
+            latency_us = 20000 + (uint32_t) (rand() % 200000);
+        }
+        samples[i] = latency_us;
+        latency_histogram_add(&histogram, latency_us);
+    }
+    qsort(samples, NUM_SAMPLES, sizeof(uint32_t), &compare_uint32);
+
+    CHECK_EQUAL(NUM_SAMPLES, latency_histogram_get_count(&histogram));
+    CHECK_EQUAL(samples[NUM_SAMPLES - 1], latency_histogram_get_max(&histogram));
+
+    static const uint32_t percents[] = { 1, 50, 90, 99, 100 };
+    unsigned int p;
+    for (p = 0; p < sizeof(percents) / sizeof(percents[0]); p++){
+        uint32_t exact = exact_percentile(samples, NUM_SAMPLES, percents[p]);
+        uint32_t reported = latency_histogram_get_percentile(&histogram, percents[p]);
+        if ((reported < exact) || ((uint64_t) reported * 4 > (uint64_t) exact * 5 + 3)){
+            printf("p%u: exact %u us, reported %u us\n", percents[p], exact, reported);
+            test_failures++;
+        }
+    }
+    CHECK_EQUAL(latency_histogram_get_max(&histogram), latency_histogram_get_percentile(&histogram, 100));
+}
+
+int main(void){
+    test_empty();
+    test_single_values();
+    test_percentiles();
+    return test_result("test_latency_histogram");
+}